@@ -1,6 +1,8 @@
 #ifndef _ALIGNER_PARAMS_H_
 #define _ALIGNER_PARAMS_H_
 
+#include "ContigScoring.h"
+
 //=====================================================================
 
 /**
@@ -19,17 +21,17 @@ class AlignerParams {
 public:
   // Default Ctor
   AlignerParams():bandWidth(-1), alignerType(NSGA), useAlignerDef(true),
-      gapOpenP(0), mismatchP(0), gapExtP(0) { setDefaults(); }
+      gapOpenP(0), mismatchP(0), gapExtP(0), numThreads(1), xDrop(-1), adaptiveBand(false), tracebackMemory(64), localized(false) { setDefaults(); }
   // Ctor 2
   AlignerParams(int bandW):bandWidth(bandW), alignerType(NSGA), useAlignerDef(true),
-      gapOpenP(0), mismatchP(0), gapExtP(0) { setDefaults(); }
+      gapOpenP(0), mismatchP(0), gapExtP(0), numThreads(1), xDrop(-1), adaptiveBand(false), tracebackMemory(64), localized(false) { setDefaults(); }
   // Ctor 2
   AlignerParams(int bandW, AlignerType type):bandWidth(bandW), alignerType(type), useAlignerDef(true),
-      gapOpenP(0), mismatchP(0), gapExtP(0) { setDefaults(); }
+      gapOpenP(0), mismatchP(0), gapExtP(0), numThreads(1), xDrop(-1), adaptiveBand(false), tracebackMemory(64), localized(false) { setDefaults(); }
   // Ctor 3
   AlignerParams(int bandW, AlignerType type, int goPen, int mmPen,
        int gePen):bandWidth(bandW), alignerType(type), useAlignerDef(false),
-        gapOpenP(goPen), mismatchP(mmPen), gapExtP(gePen) {}
+        gapOpenP(goPen), mismatchP(mmPen), gapExtP(gePen), numThreads(1), xDrop(-1), adaptiveBand(false), tracebackMemory(64), localized(false) {}
 
 // Setters
   void setType(AlignerType at)   { alignerType = at;  }
@@ -37,6 +39,12 @@ public:
   void setMismatchP(int mp)      { mismatchP   = mp;  }
   void setGapExtP(int gep)       { gapExtP     = gep; }
   void setBandWidth(int bw)      { bandWidth   = bw;  }
+  void setNumThreads(int n)      { numThreads  = n;   }
+  void setXDrop(int x)           { xDrop       = x;   }
+  void setAdaptiveBand(bool ab)  { adaptiveBand = ab; }
+  void setTracebackMemory(int mb) { tracebackMemory = mb; }
+  void setLocalized(bool l)      { localized   = l;   }
+  void setContigScoring(const ContigScoring& cs) { contigScoring = cs; }
 
 // Getters
   AlignerType getType()const   { return alignerType; }
@@ -45,6 +53,12 @@ public:
   int  getGapExtP()const       { return gapExtP; }
   bool useDefaults()const      { return useAlignerDef; }
   int  getBandWidth()const     { return bandWidth; }
+  int  getNumThreads()const    { return numThreads; }
+  int  getXDrop()const         { return xDrop; }
+  bool isAdaptiveBand()const   { return adaptiveBand; }
+  int  getTracebackMemory()const { return tracebackMemory; }
+  bool isLocalized()const      { return localized; }
+  const ContigScoring& getContigScoring()const { return contigScoring; }
 
 private:
   /** Set the param defaults if they haven't been given in the constructor */
@@ -83,6 +97,12 @@ private:
   int gapOpenP;            /// Gap Open Penalty
   int mismatchP;           /// Mismatch penalty
   int gapExtP;             /// Gap extension penalty
+  int numThreads;          /// The number of threads for a single alignment (see WavefrontState and NSaligner::traverseGraph)
+  int xDrop;               /// Cells scoring more than this below the best one are not extended while finding the end (see NSaligner::traverseColumnsXDrop), -1 for none
+  bool adaptiveBand;       /// Whether the band follows the best scoring diagonal instead of the main one (see EditGraph::centerNextBand)
+  int tracebackMemory;     /// The memory in MB a section of the graph may take for keeping the parent of every node rather than being checkpointed (see TracebackMatrix), 0 for none
+  bool localized;          /// Whether the alignment is only traced within the bounding box found by a score-only pass, SWGA/SW only (see Cola::alignLocalized)
+  ContigScoring contigScoring; /// The scoring of contiguous matches (NSGA and NS only)
 };
 
 #endif //_ALIGNER_PARAMS_H_
@@ -4,109 +4,242 @@
 
 #include <fstream>
 #include <cmath>
+#include <algorithm>
+#include <sstream>
+#include <utility>
 #include "AlignmentCola.h"
 
 //=====================================================================
 void AlignmentCola::traceAlignment(bool tracePrefix) {
-  if(pathNodes.begin()==pathNodes.end()) { return; } // Return if path is empty
+  if(pathNodes.empty()) { return; } // Return if path is empty
+  sortPath();
   
   int currRow, currCol,prevRow, prevCol;
+  int numNodes = pathNodes.size();
   
   // Start from the first node on the path and build up the alignment
   // by tracing to the end. To do this we need to compare each cell
   // with its predecessor and choose the score based on the transition
-  map<int, EditGraphNode>::iterator iter = pathNodes.begin();
-  currRow = iter->second.getRow()-1;
-  currCol = iter->second.getCol()-1;
+  currRow = pathNodes[0].getRow()-1;
+  currCol = pathNodes[0].getCol()-1;
 
-  // Make sure containers are reset
-  info.resetCalculations(iter->second.getCol(), iter->second.getRow());
-  resetContainers();
+  // Make sure containers are reset, each node adds one column to the runs
+  info.resetCalculations(pathNodes[0].getCol(), pathNodes[0].getRow());
+  clearExpanded();
+  runs.clear();
 
-  for( ; iter != pathNodes.end(); iter++) {
+  for(int i=0; i<numNodes; i++) {
+    const EditGraphNode& node = pathNodes[i];
     if(!tracePrefix) {
       //Reset everything if node with 0 score - This removes the 
       // prefix section of the alignment which would have a negative score.
-      if(iter->second.getScore()<=0) {
-        resetContainers();
+      if(node.getScore()<=0) {
+        runs.clear();
         // Set target and query offsets and reset other fields
-        if(++iter==pathNodes.end()) { break; }
-        info.resetCalculations(iter->second.getCol(), iter->second.getRow());
-        iter--;
+        if(i+1==numNodes) { break; }
+        info.resetCalculations(pathNodes[i+1].getCol(), pathNodes[i+1].getRow());
         // Set the currRow/col to be used in next basepair alignment
-        currRow = iter->second.getRow() - 1;
-        currCol = iter->second.getCol() - 1;
+        currRow = node.getRow() - 1;
+        currCol = node.getCol() - 1;
         continue;  
       }
     }
     prevRow  = currRow;
     prevCol  = currCol; 
-    currRow  = iter->second.getRow();
-    currCol  = iter->second.getCol();
+    currRow  = node.getRow();
+    currCol  = node.getCol();
     
-    char queryLetter  = querySeq[currRow];
-    char targetLetter = targetSeq[currCol];
-
     if( (currRow != prevRow && currCol != prevCol) ){ // Diagonal move
-      targetStr += targetLetter;
-      targetIdxsInQuery[currCol] = currRow;
-      queryStr += queryLetter;
-      queryIdxsInTarget[currRow] = currCol;
-      if( queryLetter == targetLetter) {
-        matchesStr += MATCH_CHAR;
-        info.baseMatched++;
-      } else {
-        matchesStr += MISMATCH_CHAR;  
-      }
-      info.tBaseAligned++;
-      info.qBaseAligned++;
+      addColumn(querySeq[currRow]==targetSeq[currCol]? MATCH_OP : MISMATCH_OP);
     } else if( currRow != prevRow) {                  // Vertical move
-      targetStr += GAP_CHAR;
-      queryStr += queryLetter;
-      matchesStr += MISMATCH_CHAR;  
-      info.qBaseAligned++;
+      addColumn(INSERT_OP);
     } else {                                          // Horizontal move
-      queryStr   += GAP_CHAR;
-      targetStr  += targetLetter;
-      matchesStr += MISMATCH_CHAR;  
-      info.tBaseAligned++;
+      addColumn(DELETE_OP);
     }
-    updateSWScore(); // update the smith-waterman score
   }
 
-  // Set score value from the last node on the path (get from iterator used above)
-  info.rawScore = (--iter)->second.getScore();  
-  info.alignmentLen = matchesStr.size();
+  // Set score value from the last node on the path
+  info.rawScore = pathNodes.back().getScore();  
+  info.alignmentLen = countColumns();
+  endNode    = pathNodes.back();
+  pathLength = numNodes;
+  // The runs replace the path, the capacity is kept for the next alignment
+  pathNodes.clear();
 } 
 
-void AlignmentCola::updateSWScore() {
-  // If the latest added bases match, add 1 to the score and otherwise subtract 1
-  if(queryStr[queryStr.size()-1] == targetStr[targetStr.size()-1]) { info.smithWatermanScore++;} 
-  else { info.smithWatermanScore--; }
+void AlignmentCola::addColumn(char op) {
+  if(runs.empty() || runs.back().op!=op) { runs.push_back(AlignmentRun(op, 0)); }
+  runs.back().length++;
+  // Add 1 to the smith-waterman score if the bases match and otherwise subtract 1
+  if(op==MATCH_OP) { 
+    info.baseMatched++;
+    info.smithWatermanScore++;
+  } else { 
+    info.smithWatermanScore--; 
+  }
+  if(op!=INSERT_OP) { info.tBaseAligned++; }
+  if(op!=DELETE_OP) { info.qBaseAligned++; }
 }  
 
-void AlignmentCola::addNodeToPath(EditGraphNode* node) {
-  pathNodes[(node->getRow() + node->getCol())] = *node;
-} 
+int AlignmentCola::countColumns() const {
+  int numColumns = 0;
+  for(int i=0; i<(int)runs.size(); i++) { numColumns += runs[i].length; }
+  return numColumns;
+}
+
+void AlignmentCola::clearExpanded() {
+  targetStr.clear();
+  queryStr.clear();
+  matchesStr.clear();
+  targetIdxsInQuery.clear();
+  queryIdxsInTarget.clear();
+}
+
+void AlignmentCola::expand() {
+  resetContainers();
+  targetStr.reserve(info.alignmentLen);
+  queryStr.reserve(info.alignmentLen);
+  matchesStr.reserve(info.alignmentLen);
+  int targetIdx = info.targetOffset;
+  int queryIdx  = info.queryOffset;
+  for(int i=0; i<(int)runs.size(); i++) {
+    char op = runs[i].op;
+    for(int k=0; k<runs[i].length; k++) {
+      if(op==INSERT_OP) {
+        targetStr  += GAP_CHAR;
+        queryStr   += querySeq[queryIdx++];
+        matchesStr += MISMATCH_CHAR;
+      } else if(op==DELETE_OP) {
+        targetStr  += targetSeq[targetIdx++];
+        queryStr   += GAP_CHAR;
+        matchesStr += MISMATCH_CHAR;
+      } else {
+        targetIdxsInQuery[targetIdx] = queryIdx;
+        queryIdxsInTarget[queryIdx]  = targetIdx;
+        targetStr  += targetSeq[targetIdx++];
+        queryStr   += querySeq[queryIdx++];
+        matchesStr += (op==MATCH_OP)? MATCH_CHAR : MISMATCH_CHAR;
+      }
+    }
+  }
+}
+
+AlignmentCola AlignmentCola::getExpanded() const {
+  AlignmentCola expanded(*this);
+  expanded.expand();
+  return expanded;
+}
+
+AlignmentCola AlignmentCola::release() {
+  vector<EditGraphNode> pathBuffer;
+  pathBuffer.swap(pathNodes);
+  AlignmentCola released(std::move(*this));
+  pathNodes.swap(pathBuffer);
+  runs.clear();
+  endNode    = EditGraphNode();
+  pathLength = 0;
+  info.resetCalculations(0, 0);
+  return released;
+}
+
+string AlignmentCola::getCigar() const {
+  stringstream cigar;
+  for(int i=0; i<(int)runs.size(); i++) { cigar << runs[i].length << runs[i].op; }
+  return cigar.str();
+}
+
+int AlignmentCola::getQueryAlignIndexForTarget(int targetIdx) const {
+  int currTarget = info.targetOffset;
+  int currQuery  = info.queryOffset;
+  for(int i=0; i<(int)runs.size() && currTarget<=targetIdx; i++) {
+    char op = runs[i].op;
+    int len = runs[i].length;
+    if(op==INSERT_OP) { 
+      currQuery += len;
+      continue;
+    }
+    if(targetIdx<currTarget+len) { return (op==DELETE_OP)? -1 : currQuery+targetIdx-currTarget; }
+    currTarget += len;
+    if(op!=DELETE_OP) { currQuery += len; }
+  }
+  return -1;
+}
+
+char AlignmentCola::getQueryAlignCharForTarget(int targetIdx) const {
+  int queryIdx = getQueryAlignIndexForTarget(targetIdx);
+  return (queryIdx<0)? GAP_CHAR : querySeq[queryIdx];
+}
+
+void AlignmentCola::reset(const DNAVector& tSeq, const DNAVector& qSeq, const AlignerParams& p) {
+  Alignment::operator=(Alignment(tSeq, qSeq));
+  clearExpanded();
+  pathNodes.clear();
+  runs.clear();
+  endNode    = EditGraphNode();
+  pathLength = 0;
+  params = p;
+}
+
+/** Orders path nodes by their anti-diagonal */
+static bool isBeforeOnPath(const EditGraphNode& a, const EditGraphNode& b) {
+  return a.getRow()+a.getCol() < b.getRow()+b.getCol();
+}
+
+void AlignmentCola::sortPath() {
+  // The sort is stable, so the nodes on the same anti-diagonal stay in the order they were added
+  stable_sort(pathNodes.begin(), pathNodes.end(), isBeforeOnPath);
+  int numKept = 0;
+  for(int i=0; i<(int)pathNodes.size(); i++) {
+    if(numKept>0 && !isBeforeOnPath(pathNodes[numKept-1], pathNodes[i])) {
+      pathNodes[numKept-1] = pathNodes[i];
+    } else {
+      pathNodes[numKept++] = pathNodes[i];
+    }
+  }
+  pathNodes.resize(numKept);
+}
+
+void AlignmentCola::takePathNodes(AlignmentCola& other) {
+  pathNodes.insert(pathNodes.end(), other.pathNodes.begin(), other.pathNodes.end());
+  other.pathNodes.clear();
+}
 
 void AlignmentCola::keepSubalignment(int start, int end) {
   if(start>=getLength() || (start-end)>=getLength()) { cerr<<"Error cutting down alignment"<<endl; }
   
-  int counter = 0;
-  map<int, EditGraphNode>::iterator iter = pathNodes.begin();
-  while( iter != pathNodes.end()) {
-    if(counter<start || counter>end) {  
-      pathNodes.erase(iter++);
-    } else { iter++; }
-    counter++;  
+  // The path nodes before the first column were trimmed as a prefix with no positive score
+  int numTrimmed = pathLength - info.alignmentLen;
+  int firstCol   = max(start-numTrimmed, 0);
+  int lastCol    = min(end-numTrimmed, info.alignmentLen-1);
+  pathLength     = max(min(end+1, pathLength) - max(start, 0), 0);
+
+  // Only the columns from start to end are kept, the others are skipped over
+  vector<AlignmentRun> allRuns;
+  allRuns.swap(runs);
+  double rawScore = info.rawScore;
+  int targetIdx   = info.targetOffset;
+  int queryIdx    = info.queryOffset;
+  int col         = 0;
+  for(int i=0; i<(int)allRuns.size() && col<=lastCol; i++) {
+    char op = allRuns[i].op;
+    for(int k=0; k<allRuns[i].length && col<=lastCol; k++, col++) {
+      if(col==firstCol) { info.resetCalculations(targetIdx, queryIdx); }
+      if(col>=firstCol) { addColumn(op); }
+      if(op!=INSERT_OP) { targetIdx++; }
+      if(op!=DELETE_OP) { queryIdx++; }
+    }
   }
-  // Retrace alignment from updated path nodes
-  traceAlignment();
-  
-  
+  if(runs.empty()) { info.resetCalculations(targetIdx, queryIdx); }
+  info.rawScore     = rawScore;
+  info.alignmentLen = countColumns();
+  endNode = EditGraphNode(queryIdx-1, targetIdx-1, 0, endNode.getScore(), 0, 0);
 }
 
 double AlignmentCola::calcPVal() const {
+  return calcPValOfScore(calcModSWScore());
+}
+
+double AlignmentCola::calcPValOfScore(double x) const {
 // TODO Currently this only considers defaults
 //  and also uses conditionals which is not nice  
 
@@ -131,7 +264,6 @@ double AlignmentCola::calcPVal() const {
     case UNUSED:
       break;
   }
-  double x      = calcModSWScore();
   double p      = 1 - exp(-exp(-lambda*(x-mu)));
   return p;
 }
@@ -145,6 +277,6 @@ void AlignmentCola::printFull(double pValLimit, ostream& sout, int screenWidth)
        << "Gap Extension Penalty:            " << params.getGapExtP()   << endl
        << "Mismatch Penalty:                 " << params.getMismatchP() << endl
        << "**********************************************"              << endl;
-  Alignment::printFull(pValLimit, sout, screenWidth);
+  getExpanded().Alignment::printFull(pValLimit, sout, screenWidth);
 }
  
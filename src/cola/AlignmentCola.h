@@ -10,12 +10,89 @@
 #define MATCH_CHAR    '|'
 #define MISMATCH_CHAR ' '
 
+// The operations of the alignment columns, as in CIGAR strings
+#define MATCH_OP    '='  // Aligned bases that match
+#define MISMATCH_OP 'X'  // Aligned bases that differ
+#define INSERT_OP   'I'  // A query base against a gap in the target
+#define DELETE_OP   'D'  // A target base against a gap in the query
+
+//===================================================================
+/** A run of alignment columns with the same operation */
+struct AlignmentRun
+{
+  AlignmentRun(char o = MATCH_OP, int len = 0): op(o), length(len) {}
+
+  char op;    /// The operation of the columns, one of the *_OP characters
+  int length; /// The number of columns
+};
+
+//===================================================================
+/**
+ * The outcome of the score-only pass of an aligner: the best local alignment
+ * score and the cells the alignment starts and ends on. The extent of the
+ * alignment bounds its identity and Smith-Waterman score, so it can be used
+ * to decide whether the alignment can pass the thresholds before tracing it.
+ * The start is approximate where equally scored paths lead to the end.
+ */
+struct AlignmentScore
+{
+  AlignmentScore(): score(0), targetStart(-1), queryStart(-1), targetEnd(-1), queryEnd(-1), scoreSWBound(INT_MAX) {}
+  AlignmentScore(ColaScore s, int tStart, int qStart, int tEnd, int qEnd): score(s),
+    targetStart(tStart), queryStart(qStart), targetEnd(tEnd), queryEnd(qEnd), scoreSWBound(INT_MAX) {}
+
+  /**
+   * Bound the Smith-Waterman score with the alignment score: if every match
+   * scores at least 1 and every other column costs at most maxCost, then
+   * matches <= score + maxCost*others, which limits matches - others.
+   * @param[in] minMatchScore: The minimum score of a match
+   * @param[in] maxCost: The maximum cost of a mismatch or gap column
+   */
+  void setScoreBound(int minMatchScore, int maxCost) {
+    if(!isAligned() || minMatchScore<1 || maxCost<1) { return; }
+    long long shorter = min(getTargetLen(), getQueryLen());
+    scoreSWBound = (int)((score + (maxCost-1)*shorter)/maxCost);
+  }
+
+  /** Returns true if there is a local alignment, i.e. there is a positive score */
+  bool isAligned() const { return score>0; }
+
+  /** The number of target/query bases covered by the alignment */
+  int getTargetLen() const { return isAligned()? targetEnd-targetStart+1 : 0; }
+  int getQueryLen() const  { return isAligned()? queryEnd-queryStart+1 : 0; }
+
+  /** The approximate length of the alignment, at least the longer of the covered lengths */
+  int getApproxLength() const { return max(getTargetLen(), getQueryLen()); }
+
+  /**
+   * Upper bound of the Smith-Waterman score (+1 per match, -1 otherwise): at
+   * most the shorter covered length can match and the rest has to be gaps,
+   * and the alignment score limits the matches too (see setScoreBound)
+   */
+  int getMaxSWScore() const {
+    return min(2*min(getTargetLen(), getQueryLen()) - getApproxLength(), scoreSWBound);
+  }
+
+  /** Upper bound of the identity */
+  double getMaxIdentity() const {
+    return isAligned()? (double)min(getTargetLen(), getQueryLen())/getApproxLength() : 0;
+  }
+
+  ColaScore score; /// The best local alignment score
+  int targetStart; /// The first target base of the alignment, -1 if nothing aligns
+  int queryStart;  /// The first query base of the alignment, -1 if nothing aligns
+  int targetEnd;   /// The last target base of the alignment, -1 if nothing aligns
+  int queryEnd;    /// The last query base of the alignment, -1 if nothing aligns
+  int scoreSWBound; /// Bound of the Smith-Waterman score from the alignment score, see setScoreBound
+};
+
 
 //===================================================================
 /** 
  * Alignment class represents an alignment, which can be created from an aligned editGraph
  * The alignment can be represented by the one editgraphNode or by backtracing this and 
  * finding the aligned sequence coordinates.
+ * Once traced the alignment is kept as runs of column operations starting from the
+ * target/query offsets, the aligned strings and index maps are only built on demand.
  */
 class AlignmentCola:public Alignment
 {
@@ -24,18 +101,56 @@ public:
   // Ctor  - Can be used as default with no params or given as many of the params in order as available
   AlignmentCola(const DNAVector& tSeq = DNAVector(), const DNAVector& qSeq = DNAVector(),
                 const AlignerParams& p = AlignerParams())
-    :Alignment(tSeq,qSeq), pathNodes(), params(p)  {}
+    :Alignment(tSeq,qSeq), pathNodes(), runs(), endNode(), pathLength(0), params(p)  { clearExpanded(); }
+
+  /** Start over for other sequences and parameters, e.g. when the aligner is reused */
+  void reset(const DNAVector& tSeq, const DNAVector& qSeq, const AlignerParams& p);
+
+  /** Get the number of nodes on the traced path, including a prefix trimmed from the alignment */
+  int getLength() const { return pathLength; }
+
+  /** Get the node the alignment ends on, i.e. the last node on the path, once traced */
+  EditGraphNode getEndNode() const { return endNode; }
+
+  /** The columns of the traced alignment as runs of the same operation */
+  const vector<AlignmentRun>& getRuns() const { return runs; }
 
-  /** Get the number of elements in the alignment (i.e. alignment length) */
-  int getLength() const { return pathNodes.size(); }
+  /** The runs of the alignment in CIGAR format, e.g. 12=1X3I */
+  string getCigar() const;
+
+  /** The query base aligned to the given target base, -1 if it is not aligned to one */
+  int getQueryAlignIndexForTarget(int targetIdx) const;
+
+  /** The query letter aligned to the given target base, GAP_CHAR if it is not aligned to one */
+  char getQueryAlignCharForTarget(int targetIdx) const;
+
+  /** A copy of the alignment with the aligned strings and index maps of Alignment built */
+  AlignmentCola getExpanded() const;
+
+  /**
+   * Move the alignment out, leaving this one empty. The buffer of the path
+   * stays behind, so that an aligner keeps it for its next alignment.
+   */
+  AlignmentCola release();
 
   /** 
-   * Add node to the optimal path nodes
+   * Add node to the optimal path nodes. The nodes are only put in order when
+   * the alignment is traced, of the nodes on the same anti-diagonal (row+col)
+   * the one added last is kept.
+   */
+  void addNodeToPath(const EditGraphNode& node) { pathNodes.push_back(node); }
+
+  /** Reserve room for the given number of path nodes, e.g. the lengths of the aligned sections */
+  void reservePath(int numNodes) { pathNodes.reserve(numNodes); }
+
+  /**
+   * Add the path nodes found by another aligner of the same sequences, e.g. over
+   * a later part of the graph, and clear them from the other alignment
    */
-  void addNodeToPath(EditGraphNode* node);
+  void takePathNodes(AlignmentCola& other);
 
   /**
-   * Produce alignment from the path nodes
+   * Produce alignment from the path nodes, which are cleared once traced
    * @parameter - choose whether beginning part of alignment that has negative score is traced
    */
   void traceAlignment(bool tracePrefix = false);
@@ -43,8 +158,9 @@ public:
   /**
    * Confines the existing alignment to the start/end boundaries
    * Used for only keeping the alignment from start to end points
-   * and discarding the rest. 
-   * All fields of alignment/info will be updated accordingly
+   * and discarding the rest. The boundaries are indexes of the path nodes.
+   * All fields of alignment/info will be updated accordingly, except for
+   * the raw score which stays that of the whole alignment.
    */
   void keepSubalignment(int start, int end);
   
@@ -55,14 +171,32 @@ public:
    * of an underlying binomial distribution estimated by the findColaSigDist module
    */
   virtual double calcPVal() const;
+
+  /** The P-value of an alignment with the given Smith-Waterman score (see calcPVal) */
+  double calcPValOfScore(double modSWScore) const;
   
   virtual void printFull(double pValLimit, ostream& sout,  int screenWidth) const;
 
 private:
-  /** Use to update smith-waterman score after each iteration in finding the alignment path**/
-  void updateSWScore();
+  /** Add a column to the runs and update the counts and smith-waterman score of the alignment */
+  void addColumn(char op);
+
+  /** The number of columns in the runs */
+  int countColumns() const;
+
+  /** Clear the aligned strings and index maps of Alignment, which the runs replace */
+  void clearExpanded();
+
+  /** Build the aligned strings and index maps of Alignment from the runs */
+  void expand();
+
+  /** Sort the path nodes by anti-diagonal, keeping the node added last of those on the same one */
+  void sortPath();
 
-  map<int,EditGraphNode> pathNodes;  /// Nodes on the optimal path mapped to increasing value: row+col 
+  vector<EditGraphNode> pathNodes;   /// Nodes on the optimal path until it is traced
+  vector<AlignmentRun> runs;         /// The columns of the traced alignment
+  EditGraphNode endNode;             /// The last node on the traced path
+  int pathLength;                    /// The number of nodes on the traced path
   AlignerParams params;              /// Include the type of aligner and relevant params used for this alignment
 };
 
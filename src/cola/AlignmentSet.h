@@ -23,7 +23,10 @@ public:
    * Add an alignment to the list of alignments held by the set
    * A const reference to the alignment is accepted and used to create copy to keep
    */
-  void add(const AlignmentCola& algn) { alignments.push_back(AlignmentCola(algn));}
+  void add(const AlignmentCola& algn) { alignments.push_back(algn); }
+
+  /** Add an alignment to the set, moving it in instead of copying it (see Cola::takeAlignment) */
+  void add(AlignmentCola&& algn) { alignments.emplace_back(std::move(algn)); }
 
   /** 
    * Return the Nth alignment in the order that they were created
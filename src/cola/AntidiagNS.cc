@@ -0,0 +1,42 @@
+#ifndef FORCE_DEBUG
+#define NDEBUG
+#endif
+
+#include <algorithm>
+#include "AntidiagNS.h"
+#include "SIMDDispatch.h"
+
+// Sections with fewer rows or columns than this are left to the node by node traversal
+#define ANTIDIAG_MIN_LEN 32
+
+//=====================================================================
+bool AntidiagNS::isSupported() {
+  return getSIMDLevel()>=SIMD_SSE41;
+}
+
+bool AntidiagNS::isApplicable(const AntidiagTraversal& trav) const {
+  int nRows = trav.endRow - trav.startRow + 1;
+  int nCols = trav.endCol - trav.startCol;
+  if(std::min(nRows, nCols)<ANTIDIAG_MIN_LEN) { return false; }
+  // Checkpoint ancestors are not carried over from the start column
+  if(!trav.trackOrigin && (trav.checkpointCol<=trav.startCol || trav.checkpointCol>trav.endCol)) { return false; }
+  // The kernel keeps the base depths in vectors and the nodes above them in lists
+  if(trav.maxContigDepth<EDITGRAPH_BASE_DEPTHS || contigScores.getMaxDepth()<EDITGRAPH_BASE_DEPTHS-1) { return false; }
+  // Penalties and rewards added in the vectors need to leave headroom below the score limit
+  const int bound = ANTIDIAG_SCORE_LIMIT/2;
+  int adds[] = { params.getGapOpenP(), params.getGapExtP(), params.getMismatchP(),
+                 contigScores.getIncrement(1), contigScores.getIncrement(2), contigScores.getIncrement(3) };
+  for(int i=0; i<(int)(sizeof(adds)/sizeof(adds[0])); i++) {
+    if(adds[i]<-bound || adds[i]>bound) { return false; }
+  }
+  return trav.startColumn->getBestScore(trav.startRow)<ANTIDIAG_SCORE_LIMIT;
+}
+
+bool AntidiagNS::traverse(const DNAVector& tSeq, const DNAVector& qSeq, AntidiagTraversal& trav) const {
+  if(!isSupported() || !isApplicable(trav)) { return false; }
+  switch(getSIMDLevel()) {
+    case SIMD_AVX512BW: return antidiagNSavx512(tSeq, qSeq, params, contigScores, trav);
+    case SIMD_AVX2:     return antidiagNSavx2(tSeq, qSeq, params, contigScores, trav);
+    default:            return antidiagNSsse41(tSeq, qSeq, params, contigScores, trav);
+  }
+}
@@ -0,0 +1,151 @@
+#ifndef _ANTIDIAGNS_H_
+#define _ANTIDIAGNS_H_
+
+#include "ryggrad/src/general/DNAVector.h"
+#include "EditGraph.h"
+#include "ContigScoring.h"
+#include "AlignerParams.h"
+
+// The kernel gives up on a section once a score reaches this, adding a penalty or reward to it then still fits in 32 bits
+#define ANTIDIAG_SCORE_LIMIT (1<<30)
+
+//=====================================================================
+/**
+ * The cells of a column of a section scored by the anti-diagonal kernel, kept
+ * row by row from the start row of the section as they are stored in the edit
+ * graph: the nodes at the base depths, those above them and the best depth.
+ */
+struct AntidiagColumn
+{
+  AntidiagColumn(): scores(), CPAs(), bestDepths(), deepOffsets(), deepNodes() {}
+
+  void clear() {
+    scores.clear();
+    CPAs.clear();
+    bestDepths.clear();
+    deepOffsets.clear();
+    deepNodes.clear();
+  }
+
+  /** Store the cells in a column of the edit graph, from the given row on */
+  void copyTo(int startRow, EditGraphColumn& column) const {
+    for(int i=0; i<(int)bestDepths.size(); i++) {
+      int row = startRow + i;
+      column.initCell(row);
+      for(int depth=0; depth<EDITGRAPH_BASE_DEPTHS; depth++) {
+        const EditGraphCPA& cpa = CPAs[i*EDITGRAPH_BASE_DEPTHS + depth];
+        column.setNode(row, depth, scores[i*EDITGRAPH_BASE_DEPTHS + depth], cpa.row, cpa.depth);
+      }
+      int end = (i+1<(int)deepOffsets.size())? deepOffsets[i+1] : deepNodes.size();
+      for(int n=deepOffsets[i]; n<end; n++) {
+        column.setNode(row, deepNodes[n].depth, deepNodes[n].score, deepNodes[n].CPA.row, deepNodes[n].CPA.depth);
+      }
+      column.setBestDepth(row, bestDepths[i]);
+    }
+  }
+
+  vector<ColaScore>    scores;      /// The scores of the nodes at the base depths, by cell
+  vector<EditGraphCPA> CPAs;        /// Their checkpoint ancestor coordinates
+  vector<int>          bestDepths;  /// The depth of the best node of each cell
+  vector<int>          deepOffsets; /// The index of the first node above the base depths of each cell
+  vector<EditGraphDeepNode> deepNodes; /// The nodes above the base depths, in increasing depth by cell
+};
+
+//=====================================================================
+/**
+ * A section of the edit graph of the NSGA/NS aligners scored by the anti-diagonal
+ * kernel, with the results needed by the checkpoint recursion of NSaligner::traverseGraph:
+ * the cells of the checkpoint and end columns and the best scored node. Rows are query
+ * positions and columns target positions, as in the EditGraph. In the score-only pass
+ * (trackOrigin) only the best node is kept, its checkpoint ancestor fields hold its origin.
+ */
+struct AntidiagTraversal
+{
+  /**
+   * @param[in] sRow, sCol: The start cell, which is set from the previous recursion
+   * @param[in] eRow, eCol: The end cell
+   * @param[in] cpCol: The column that is checkpointed, TRACK_ORIGIN in the score-only pass
+   * @param[in] findBest: Whether the best scored node has to be found
+   * @param[in] startColumn: The start column of the section, holding the start cell
+   * @param[in] affine: Whether the first two depths are the affine gaps (NSGA)
+   */
+  AntidiagTraversal(int sRow, int sCol, int eRow, int eCol, int cpCol, bool findBest,
+                    const EditGraphColumn* startColumn, bool affine): startRow(sRow), startCol(sCol),
+    endRow(eRow), endCol(eCol), checkpointCol(cpCol), findBestNode(findBest),
+    trackOrigin(cpCol==TRACK_ORIGIN), affineGaps(affine), startColumn(startColumn),
+    targetLen(0), queryLen(0), maxContigDepth(0), checkpointCells(), endCells(), bestNode(), numNodes(0) {}
+
+  int startRow;          /// The row of the start cell
+  int startCol;          /// The column of the start cell
+  int endRow;            /// The last row visited
+  int endCol;            /// The last column visited
+  int checkpointCol;     /// The column that is checkpointed
+  bool findBestNode;     /// Whether the best scored node is needed
+  bool trackOrigin;      /// Whether the start of the alignments is kept instead of checkpoint ancestors
+  bool affineGaps;       /// Whether the aligner is NSGA rather than NS
+  const EditGraphColumn* startColumn; /// The column holding the start cell
+  int targetLen;         /// The sequence lengths and the maximum depth of the edit graph, which
+  int queryLen;          /// bound the runs of matches when dropping nodes (see NSaligner::visitDeepNodes)
+  int maxContigDepth;
+
+  AntidiagColumn checkpointCells; /// The cells of the checkpoint column
+  AntidiagColumn endCells;        /// The cells of the end column
+  EditGraphNode bestNode;         /// The best scored node (the first in column, row, depth order)
+  double numNodes;                /// The number of nodes visited (see NSaligner::visitColumns)
+};
+
+//=====================================================================
+/**
+ * Anti-diagonal kernel for scoring sections of the edit graph of the NSGA/NS
+ * aligners. The contiguity depth rules out striping the columns, but a node only
+ * depends on nodes of the two anti-diagonals before it, so the cells of an
+ * anti-diagonal are scored together in 32-bit SIMD lanes. The nodes deeper on a
+ * run of matches only extend the diagonal neighbour, so they are kept per diagonal
+ * and only visited for the lanes on a run. The kernel gives the same nodes as the
+ * node by node traversal (see NSGAaligner::visitNode and NSaligner::visitNode),
+ * including the choice between equally scored nodes and the nodes dropped.
+ * There is a kernel per instruction set, compiled separately and selected at
+ * runtime for the CPU (see SIMDDispatch.h), none is used without SSE4.1.
+ */
+class AntidiagNS
+{
+public:
+  /** N.B. The contiguity scores are not copied */
+  AntidiagNS(const AlignerParams& p, const ContigScoreTable& cs): params(p), contigScores(cs) {}
+
+  ~AntidiagNS() {}
+
+  /** Returns true if a kernel is available for this build and CPU */
+  static bool isSupported();
+
+  /**
+   * Returns true if the kernel can be used for the given section and the parameters,
+   * i.e. the section is large enough for the kernel to pay off and the scores fit in 32 bits
+   */
+  bool isApplicable(const AntidiagTraversal& trav) const;
+
+  /**
+   * Score the nodes of the given section.
+   * @param[in]  The target sequence
+   * @param[in]  The query sequence
+   * @param[in,out] The section to score, filled in with the results
+   * @return false if the kernel could not be used, e.g. a score reached ANTIDIAG_SCORE_LIMIT or
+   *         the best scored node is needed but there is no positive score in the section
+   */
+  bool traverse(const DNAVector& tSeq, const DNAVector& qSeq, AntidiagTraversal& trav) const;
+
+private:
+  AlignerParams params;                  /// The penalties for mismatches and gaps
+  const ContigScoreTable& contigScores;  /// The score added by each contiguous match
+};
+
+//=====================================================================
+// The kernels for each instruction set, returning false if they are unavailable in this build
+bool antidiagNSsse41(const DNAVector& tSeq, const DNAVector& qSeq, const AlignerParams& params,
+                     const ContigScoreTable& contigScores, AntidiagTraversal& trav);
+bool antidiagNSavx2(const DNAVector& tSeq, const DNAVector& qSeq, const AlignerParams& params,
+                    const ContigScoreTable& contigScores, AntidiagTraversal& trav);
+bool antidiagNSavx512(const DNAVector& tSeq, const DNAVector& qSeq, const AlignerParams& params,
+                      const ContigScoreTable& contigScores, AntidiagTraversal& trav);
+
+#endif //_ANTIDIAGNS_H_
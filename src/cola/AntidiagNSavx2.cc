@@ -0,0 +1,22 @@
+#ifndef FORCE_DEBUG
+#define NDEBUG
+#endif
+
+// N.B. This file is compiled with AVX2 enabled, the kernel is only called if the CPU supports it
+#include "AntidiagNS.h"
+#include "AntidiagNSkernel.h"
+
+//=====================================================================
+bool antidiagNSavx2(const DNAVector& tSeq, const DNAVector& qSeq, const AlignerParams& params,
+                    const ContigScoreTable& contigScores, AntidiagTraversal& trav) {
+#if defined(__AVX2__)
+  if(trav.affineGaps) {
+    AntidiagNSkernel<AVX2ops32, true> kernel(tSeq, qSeq, params, contigScores, trav);
+    return kernel.run();
+  }
+  AntidiagNSkernel<AVX2ops32, false> kernel(tSeq, qSeq, params, contigScores, trav);
+  return kernel.run();
+#else
+  return false;
+#endif
+}
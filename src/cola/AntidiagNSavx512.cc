@@ -0,0 +1,22 @@
+#ifndef FORCE_DEBUG
+#define NDEBUG
+#endif
+
+// N.B. This file is compiled with AVX-512BW enabled, the kernel is only called if the CPU supports it
+#include "AntidiagNS.h"
+#include "AntidiagNSkernel.h"
+
+//=====================================================================
+bool antidiagNSavx512(const DNAVector& tSeq, const DNAVector& qSeq, const AlignerParams& params,
+                      const ContigScoreTable& contigScores, AntidiagTraversal& trav) {
+#if defined(__AVX512BW__)
+  if(trav.affineGaps) {
+    AntidiagNSkernel<AVX512ops32, true> kernel(tSeq, qSeq, params, contigScores, trav);
+    return kernel.run();
+  }
+  AntidiagNSkernel<AVX512ops32, false> kernel(tSeq, qSeq, params, contigScores, trav);
+  return kernel.run();
+#else
+  return false;
+#endif
+}
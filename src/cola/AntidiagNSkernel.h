@@ -0,0 +1,443 @@
+#ifndef _ANTIDIAGNSKERNEL_H_
+#define _ANTIDIAGNSKERNEL_H_
+
+#include <algorithm>
+#include "AntidiagNS.h"
+#include "SIMDops.h"
+
+// N.B. This header should only be included from the translation units of the kernels, see SIMDops.h
+
+//=====================================================================
+/**
+ * Anti-diagonal scoring of a section of the NSGA/NS edit graph. The cells of
+ * anti-diagonal t (row r and column c of the section, with r+c=t) are scored from
+ * anti-diagonal t-1, holding the cells above and to the left, and t-2, holding the
+ * diagonal neighbours. The lanes of a vector are consecutive rows, so the cell
+ * above and the diagonal neighbour are a lane back. For each cell the nodes at the
+ * base depths are scored as in the node by node traversal:
+ *  - NSGA: the vertical and horizontal gaps (depths 0 and 1, see SWGAaligner::visitNode),
+ *    the move with no contiguous match (depth 2) and the first match (depth 3)
+ *  - NS: the move with no contiguous match (depth 0) and the first three matches
+ * The nodes deeper on a run of matches only extend the node a depth lower of the
+ * diagonal neighbour, so each diagonal keeps the list of those of its latest cell,
+ * which is extended, or dropped on a mismatch, as the next cell of the diagonal is
+ * visited. Only the lanes on a run of matches past the base depths visit them.
+ * Checkpoint ancestors are carried along as in EditGraphNode::setAncestorCords, but only
+ * hold the checkpoint ancestor from the checkpoint column on (or the origin with ORIGIN).
+ */
+template<class V, bool AFFINE>
+class AntidiagNSkernel
+{
+public:
+  typedef typename V::vec vec;
+
+  AntidiagNSkernel(const DNAVector& t, const DNAVector& q, const AlignerParams& p,
+                   const ContigScoreTable& cs, AntidiagTraversal& tr);
+
+  /** Score all the anti-diagonals of the section, see AntidiagNS::traverse */
+  bool run();
+
+private:
+  // The fields kept for each cell of an anti-diagonal: the nodes at the base depths with their
+  // checkpoint ancestors, those of the best node of the cell, and the number of nodes it keeps
+  // above the base depths (in the list of its diagonal)
+  enum { SCORE = 0, CPA_ROW = EDITGRAPH_BASE_DEPTHS, CPA_DEPTH = 2*EDITGRAPH_BASE_DEPTHS,
+         BEST = 3*EDITGRAPH_BASE_DEPTHS, BEST_ROW, BEST_DEPTH, DEEP_COUNT, NUM_FIELDS };
+  // The depth of the node with no contiguous match, which is after the gaps in NSGA,
+  // and the top base depth, which the nodes above extend
+  enum { ZERO_DEPTH = AFFINE? 2 : 0, TOP_DEPTH = EDITGRAPH_BASE_DEPTHS-1 };
+  // The lanes before the first row of each field, the one right before is the row above the section
+  enum { PAD = V::LANES };
+
+  /** A field of the cells of an anti-diagonal, indexed by row from -1, the last three are kept */
+  int* getField(int t, int field) { return &arena[(((t+3)%3)*NUM_FIELDS + field)*stride + PAD]; }
+
+  /** The list of the nodes above the base depths of the latest cell visited on the diagonal of a cell */
+  vector<EditGraphDeepNode>& getDeepNodes(int t, int r) { return deepLists[t - 2*r + nRows - 1]; }
+
+  /** The number of contiguous matches scored by a node at the given depth (see NSGAaligner::getMatchDepth) */
+  static int getMatchDepth(int depth) { return AFFINE? depth-2 : depth; }
+
+  /** Add a penalty/reward to the reachable scores (see addScore, the scores are kept from overflowing) */
+  vec addScores(vec v, vec p) const { return V::select(V::cmpeq(v, vNegInf), vNegInf, V::add(v, p)); }
+
+  /** Set negative scores to zero, leaving unreachable nodes as they are */
+  vec clamp(vec v) const { return V::select(V::cmpeq(v, vNegInf), vNegInf, V::max(v, vZero)); }
+
+  /**
+   * The checkpoint ancestor of the nodes taking it from their parents, their own on the
+   * checkpoint column, or their origin with ORIGIN (see EditGraphNode::setAncestorCords)
+   */
+  template<bool ORIGIN>
+  void setAncestors(vec parentScore, vec parentRow, vec parentDepth, vec depth, vec atCheckpoint,
+                    vec row, vec col, vec& cpaRow, vec& cpaDepth) const {
+    if(ORIGIN) {
+      vec isStart = V::cmpgt(vOne, parentScore);
+      cpaRow   = V::select(isStart, row, parentRow);
+      cpaDepth = V::select(isStart, col, parentDepth);
+    } else {
+      cpaRow   = V::select(atCheckpoint, row, parentRow);
+      cpaDepth = V::select(atCheckpoint, depth, parentDepth);
+    }
+  }
+
+  /** Score the cells of an anti-diagonal, returns false if a score reaches the limit */
+  template<bool ORIGIN> bool visitAntidiagonal(int t);
+
+  /** Visit the nodes of a cell above the base depths, see NSaligner::visitDeepNodes */
+  template<bool ORIGIN> bool visitDeepNodes(int t, int r, int* const* cur, int* const* diag);
+
+  /** Add the node extending the given node of the diagonal neighbour to the candidates of a cell */
+  template<bool ORIGIN> bool extendRun(const EditGraphDeepNode& parent, int row, int col, bool atCheckpoint);
+
+  /** The depth of the best node of a cell, i.e. the first holding its best score */
+  int getBestDepth(int* const* cur, int t, int r);
+
+  /** Keep a cell of the checkpoint or end column */
+  void keepCell(AntidiagColumn& cells, int* const* cur, int t, int r);
+
+  const DNAVector&  tSeq;
+  const DNAVector&  qSeq;
+  const ContigScoreTable& contigScores;
+  AntidiagTraversal& trav;
+  int nRows;                 /// The number of rows in the section
+  int nCols;                 /// The number of columns in the section after the start column
+  int checkpointOffset;      /// The column of the checkpoint column in the section
+  int stride;                /// The length of a field, including the padding
+  vector<int> arena;         /// The fields of the last three anti-diagonals
+  vector<int> queryCodes;    /// The query bases of the section by row
+  vector<int> targetCodes;   /// The target bases of the section backwards, so that an anti-diagonal reads them forwards
+  vector< vector<EditGraphDeepNode> > deepLists; /// The nodes above the base depths by diagonal
+  vector<EditGraphDeepNode> candidates;          /// The nodes above the base depths of the latest cell, before dropping
+  double numDeepNodes;       /// The number of nodes visited above the base depths
+  vec vZero, vOne, vNegInf, vGapOpen, vGapExt, vMismatch, vIota;
+  vec vDepths[EDITGRAPH_BASE_DEPTHS];     /// The base depths
+  vec vIncrements[EDITGRAPH_BASE_DEPTHS]; /// The contiguity rewards by number of matches
+};
+
+template<class V, bool AFFINE>
+AntidiagNSkernel<V, AFFINE>::AntidiagNSkernel(const DNAVector& t, const DNAVector& q, const AlignerParams& p,
+    const ContigScoreTable& cs, AntidiagTraversal& tr): tSeq(t), qSeq(q), contigScores(cs), trav(tr),
+    arena(), queryCodes(), targetCodes(), deepLists(), candidates(), numDeepNodes(0) {
+  const int lanes = V::LANES;
+  nRows  = trav.endRow - trav.startRow + 1;
+  nCols  = trav.endCol - trav.startCol;
+  stride = nRows + 3*lanes;
+  // The checkpoint column is out of the section in the score-only pass
+  checkpointOffset = trav.trackOrigin? -2*stride : trav.checkpointCol - trav.startCol;
+
+  // Lanes past the section hold bases that do not match, so that they stay unreachable
+  queryCodes.assign(stride, -1);
+  for(int r=0; r<nRows; r++) { queryCodes[PAD+r] = qSeq[trav.startRow+r]; }
+  targetCodes.assign(nCols + nRows + 3*lanes, -2);
+  for(int c=1; c<=nCols; c++) { targetCodes[PAD+nCols-c] = tSeq[trav.startCol+c]; }
+  deepLists.resize(nRows + nCols);
+
+  vZero     = V::set1(0);
+  vOne      = V::set1(1);
+  vNegInf   = V::set1(MINUS_INF);
+  vGapOpen  = V::set1(p.getGapOpenP());
+  vGapExt   = V::set1(p.getGapExtP());
+  vMismatch = V::set1(p.getMismatchP());
+  vIota     = V::iota();
+  for(int d=0; d<EDITGRAPH_BASE_DEPTHS; d++) {
+    vDepths[d]     = V::set1(d);
+    vIncrements[d] = V::set1(d>0? contigScores.getIncrement(d) : 0);
+  }
+}
+
+template<class V, bool AFFINE>
+bool AntidiagNSkernel<V, AFFINE>::run() {
+  // All cells are unreachable, but the start cell which is anti-diagonal 0
+  arena.assign(3*NUM_FIELDS*stride, 0);
+  for(int t=0; t<3; t++) {
+    for(int d=0; d<EDITGRAPH_BASE_DEPTHS; d++) { std::fill(getField(t, SCORE+d) - PAD, getField(t, SCORE+d) - PAD + stride, MINUS_INF); }
+    std::fill(getField(t, BEST) - PAD, getField(t, BEST) - PAD + stride, MINUS_INF);
+  }
+  const EditGraphColumn* start = trav.startColumn;
+  int bestDepth = start->getBestDepth(trav.startRow);
+  for(int d=0; d<EDITGRAPH_BASE_DEPTHS; d++) {
+    getField(0, SCORE+d)[0]     = start->getScore(trav.startRow, d);
+    getField(0, CPA_ROW+d)[0]   = start->getCPARow(trav.startRow, d);
+    getField(0, CPA_DEPTH+d)[0] = start->getCPADepth(trav.startRow, d);
+  }
+  getField(0, BEST)[0]       = start->getScore(trav.startRow, bestDepth);
+  getField(0, BEST_ROW)[0]   = start->getCPARow(trav.startRow, bestDepth);
+  getField(0, BEST_DEPTH)[0] = start->getCPADepth(trav.startRow, bestDepth);
+  getField(0, DEEP_COUNT)[0] = start->getNumDeepNodes(trav.startRow);
+  vector<EditGraphDeepNode>& startNodes = getDeepNodes(0, 0);
+  for(int i=0; i<start->getNumDeepNodes(trav.startRow); i++) {
+    startNodes.push_back(start->getDeepNode(trav.startRow, i));
+  }
+
+  trav.checkpointCells.clear();
+  trav.endCells.clear();
+  trav.bestNode = EditGraphNode();
+  for(int t=1; t<nRows+nCols; t++) {
+    bool scored = trav.trackOrigin? visitAntidiagonal<true>(t) : visitAntidiagonal<false>(t);
+    if(!scored) { return false; }
+  }
+  trav.numNodes = (double)nRows * nCols * EDITGRAPH_BASE_DEPTHS + numDeepNodes;
+  return !trav.findBestNode || trav.bestNode.getScore()>0;
+}
+
+template<class V, bool AFFINE>
+template<bool ORIGIN>
+bool AntidiagNSkernel<V, AFFINE>::visitAntidiagonal(int t) {
+  const int lanes = V::LANES;
+  const int rLo   = std::max(0, t-nCols);
+  const int rHi   = std::min(nRows-1, t-1);
+  int* cur[NUM_FIELDS];
+  int* prev[NUM_FIELDS];
+  int* diag[NUM_FIELDS];
+  for(int f=0; f<NUM_FIELDS; f++) {
+    cur[f]  = getField(t, f);
+    prev[f] = getField(t-1, f);
+    diag[f] = getField(t-2, f);
+  }
+  const int* tCodes = &targetCodes[PAD + nCols - t];
+  const vec vCheckpointRow = V::set1(t - checkpointOffset);
+  // The special case of the first match from outside the graph (first row/column)
+  const vec vFirstRow  = V::set1(trav.startRow==0? 0 : -1);
+  const vec vFirstCol  = V::set1(trav.startCol==-1? t-1 : -1);
+  const vec vRowOffset = V::set1(trav.startRow);
+  const vec vColOffset = V::set1(trav.startCol + t);
+  vec vMax = vNegInf;
+
+  for(int r=rLo; r<=rHi; r+=lanes) {
+    vec vR      = V::add(V::set1(r), vIota);
+    vec vInside = V::cmpgt(V::set1(rHi+1), vR);
+    vec vRow    = V::add(vR, vRowOffset);
+    vec vCol    = V::sub(vColOffset, vR);
+    vec vMatch  = V::cmpeq(V::load(&queryCodes[PAD+r]), V::load(tCodes+r));
+    vec vAtCp   = V::cmpeq(vR, vCheckpointRow);
+    vec vUpB     = V::load(prev[BEST]+r-1);
+    vec vLeftB   = V::load(prev[BEST]+r);
+    vec vDiagB   = V::load(diag[BEST]+r-1);
+    vec vScores[EDITGRAPH_BASE_DEPTHS], vRows[EDITGRAPH_BASE_DEPTHS], vDeps[EDITGRAPH_BASE_DEPTHS];
+
+    if(AFFINE) {
+      // Vertical and horizontal gaps, extended if that scores strictly higher than opening them
+      vec vUpV    = V::load(prev[SCORE]+r-1);
+      vec vVExt   = addScores(vUpV, vGapExt);
+      vec vVOpen  = addScores(vUpB, vGapOpen);
+      vec vFromV  = V::cmpgt(vVExt, vVOpen);
+      vScores[0]  = clamp(V::max(vVExt, vVOpen));
+      setAncestors<ORIGIN>(V::select(vFromV, vUpV, vUpB),
+                           V::select(vFromV, V::load(prev[CPA_ROW]+r-1), V::load(prev[BEST_ROW]+r-1)),
+                           V::select(vFromV, V::load(prev[CPA_DEPTH]+r-1), V::load(prev[BEST_DEPTH]+r-1)),
+                           vDepths[0], vAtCp, vRow, vCol, vRows[0], vDeps[0]);
+      vec vLeftH  = V::load(prev[SCORE+1]+r);
+      vec vHExt   = addScores(vLeftH, vGapExt);
+      vec vHOpen  = addScores(vLeftB, vGapOpen);
+      vec vFromH  = V::cmpgt(vHExt, vHOpen);
+      vScores[1]  = clamp(V::max(vHExt, vHOpen));
+      setAncestors<ORIGIN>(V::select(vFromH, vLeftH, vLeftB),
+                           V::select(vFromH, V::load(prev[CPA_ROW+1]+r), V::load(prev[BEST_ROW]+r)),
+                           V::select(vFromH, V::load(prev[CPA_DEPTH+1]+r), V::load(prev[BEST_DEPTH]+r)),
+                           vDepths[1], vAtCp, vRow, vCol, vRows[1], vDeps[1]);
+      // No contiguous match: the best of the gaps of the cell or a mismatch from the diagonal
+      // neighbour, the latter on ties. The former keeps the checkpoint ancestor of the gap.
+      vec vIsH      = V::cmpgt(vScores[1], vScores[0]);
+      vec vGapBest  = V::select(vIsH, vScores[1], vScores[0]);
+      vec vDiagMis  = addScores(vDiagB, vMismatch);
+      vec vFromDiag = V::andnot(V::cmpgt(vGapBest, vDiagMis), V::cmpeq(vZero, vZero));
+      vScores[2]    = clamp(V::select(vFromDiag, vDiagMis, vGapBest));
+      setAncestors<ORIGIN>(V::select(vFromDiag, vDiagB, vGapBest),
+                           V::select(vFromDiag, V::load(diag[BEST_ROW]+r-1), V::select(vIsH, vRows[1], vRows[0])),
+                           V::select(vFromDiag, V::load(diag[BEST_DEPTH]+r-1), V::select(vIsH, vDeps[1], vDeps[0])),
+                           vDepths[2], V::andv(vAtCp, vFromDiag), vRow, vCol, vRows[2], vDeps[2]);
+    } else {
+      // No contiguous match: a mismatch from the diagonal neighbour, or a gap from the cell above
+      // or to the left, in that order on ties (see NSaligner::visitNodeContigZero)
+      vec vLeftGap  = addScores(vLeftB, vGapOpen);
+      vec vUpGap    = addScores(vUpB, vGapOpen);
+      vec vDiagMis  = addScores(vDiagB, vMismatch);
+      vec vFromDiag = V::andnot(V::orv(V::cmpgt(vUpGap, vDiagMis), V::cmpgt(vLeftGap, vDiagMis)), V::cmpeq(vZero, vZero));
+      vec vFromUp   = V::cmpgt(vUpGap, vLeftGap);
+      vScores[0]    = clamp(V::select(vFromDiag, vDiagMis, V::select(vFromUp, vUpGap, vLeftGap)));
+      vec vParent    = V::select(vFromUp, vUpB, vLeftB);
+      vec vParentRow = V::select(vFromUp, V::load(prev[BEST_ROW]+r-1), V::load(prev[BEST_ROW]+r));
+      vec vParentDep = V::select(vFromUp, V::load(prev[BEST_DEPTH]+r-1), V::load(prev[BEST_DEPTH]+r));
+      setAncestors<ORIGIN>(V::select(vFromDiag, vDiagB, vParent),
+                           V::select(vFromDiag, V::load(diag[BEST_ROW]+r-1), vParentRow),
+                           V::select(vFromDiag, V::load(diag[BEST_DEPTH]+r-1), vParentDep),
+                           vDepths[0], vAtCp, vRow, vCol, vRows[0], vDeps[0]);
+    }
+
+    // Contiguous matches extend the node a depth lower of the diagonal neighbour
+    for(int d=ZERO_DEPTH+1; d<EDITGRAPH_BASE_DEPTHS; d++) {
+      vec vParent = V::load(diag[SCORE+d-1]+r-1);
+      vec vScore  = addScores(vParent, vIncrements[d-ZERO_DEPTH]);
+      if(d==ZERO_DEPTH+1) {
+        vec vFirst = V::andv(V::cmpeq(vParent, vNegInf), V::orv(V::cmpeq(vR, vFirstRow), V::cmpeq(vR, vFirstCol)));
+        vScore = V::select(vFirst, vIncrements[1], vScore);
+      }
+      vScores[d] = clamp(V::select(vMatch, vScore, vNegInf));
+      setAncestors<ORIGIN>(vParent, V::load(diag[CPA_ROW+d-1]+r-1), V::load(diag[CPA_DEPTH+d-1]+r-1),
+                           vDepths[d], vAtCp, vRow, vCol, vRows[d], vDeps[d]);
+    }
+
+    // The best node of the cell is the first holding the best score
+    vec vB = vScores[0], vBRow = vRows[0], vBDep = vDeps[0];
+    for(int d=1; d<EDITGRAPH_BASE_DEPTHS; d++) {
+      vec vIsBest = V::cmpgt(vScores[d], vB);
+      vB    = V::select(vIsBest, vScores[d], vB);
+      vBRow = V::select(vIsBest, vRows[d], vBRow);
+      vBDep = V::select(vIsBest, vDeps[d], vBDep);
+    }
+    for(int d=0; d<EDITGRAPH_BASE_DEPTHS; d++) {
+      V::store(cur[SCORE+d]+r, vScores[d]);
+      V::store(cur[CPA_ROW+d]+r, vRows[d]);
+      V::store(cur[CPA_DEPTH+d]+r, vDeps[d]);
+    }
+    V::store(cur[BEST]+r, vB);
+    V::store(cur[BEST_ROW]+r, vBRow);
+    V::store(cur[BEST_DEPTH]+r, vBDep);
+    V::store(cur[DEEP_COUNT]+r, vZero);
+
+    // The lanes matching on from the top base depth or from nodes above it visit the nodes above it
+    vec vRun = V::andv(vMatch, V::orv(V::cmpgt(V::load(diag[SCORE+TOP_DEPTH]+r-1), vNegInf),
+                                      V::cmpgt(V::load(diag[DEEP_COUNT]+r-1), vZero)));
+    int runLanes = V::movemask(V::andv(vRun, vInside));
+    if(runLanes) {
+      for(int lane=0; lane<lanes; lane++) {
+        if(((runLanes>>lane)&1) && !visitDeepNodes<ORIGIN>(t, r+lane, cur, diag)) { return false; }
+      }
+      vB = V::load(cur[BEST]+r);
+    }
+    vMax = V::max(vMax, V::select(vInside, vB, vNegInf));
+  }
+
+  // The cell of the start column on the anti-diagonal can not be reached,
+  // the cells past the end row were overwritten and are not read
+  if(t<nRows) {
+    for(int f=0; f<NUM_FIELDS; f++) { cur[f][t] = 0; }
+    for(int d=0; d<EDITGRAPH_BASE_DEPTHS; d++) { cur[SCORE+d][t] = MINUS_INF; }
+    cur[BEST][t] = MINUS_INF;
+  }
+
+  int maxScore = V::hmax(vMax);
+  if(maxScore>=ANTIDIAG_SCORE_LIMIT) { return false; }
+  if(!ORIGIN) {
+    int r = t - checkpointOffset;
+    if(r>=rLo && r<=rHi) { keepCell(trav.checkpointCells, cur, t, r); }
+    r = t - nCols;
+    if(r>=rLo && r<=rHi) { keepCell(trav.endCells, cur, t, r); }
+  }
+  // Of the cells holding the best score the lowest on the anti-diagonal is the first in column order
+  if(trav.findBestNode && maxScore>0 && maxScore>=trav.bestNode.getScore()) {
+    int r = rHi;
+    while(cur[BEST][r]!=maxScore) { r--; }
+    int col = trav.startCol + t - r;
+    if(maxScore>trav.bestNode.getScore() || col<trav.bestNode.getCol()) {
+      trav.bestNode = EditGraphNode(trav.startRow + r, col, getBestDepth(cur, t, r), maxScore,
+                                    cur[BEST_ROW][r], cur[BEST_DEPTH][r]);
+    }
+  }
+  return true;
+}
+
+template<class V, bool AFFINE>
+template<bool ORIGIN>
+bool AntidiagNSkernel<V, AFFINE>::visitDeepNodes(int t, int r, int* const* cur, int* const* diag) {
+  const int row = trav.startRow + r;
+  const int col = trav.startCol + t - r;
+  const bool atCheckpoint = !ORIGIN && (t-r == checkpointOffset);
+  vector<EditGraphDeepNode>& deepNodes = getDeepNodes(t, r);
+  candidates.clear();
+  ColaScore topScore = diag[SCORE+TOP_DEPTH][r-1];
+  if(topScore!=MINUS_INF &&
+     !extendRun<ORIGIN>(EditGraphDeepNode(TOP_DEPTH, topScore, diag[CPA_ROW+TOP_DEPTH][r-1], diag[CPA_DEPTH+TOP_DEPTH][r-1]),
+                        row, col, atCheckpoint)) {
+    return false;
+  }
+  int numDiagNodes = diag[DEEP_COUNT][r-1];
+  for(int i=0; i<numDiagNodes && deepNodes[i].depth<trav.maxContigDepth; i++) {
+    if(!extendRun<ORIGIN>(deepNodes[i], row, col, atCheckpoint)) { return false; }
+  }
+  numDeepNodes += candidates.size();
+  if(candidates.empty()) { return true; }
+
+  for(int i=0; i<(int)candidates.size(); i++) {
+    if(candidates[i].score>cur[BEST][r]) {
+      cur[BEST][r]       = candidates[i].score;
+      cur[BEST_ROW][r]   = candidates[i].CPA.row;
+      cur[BEST_DEPTH][r] = candidates[i].CPA.depth;
+    }
+  }
+  // Drop the nodes a deeper one scores higher than, as NSaligner::visitDeepNodes does
+  int topDepth  = candidates.back().depth;
+  bool canPrune = topDepth + std::min(trav.queryLen-1-row, trav.targetLen-1-col) <= trav.maxContigDepth;
+  ColaScore deeperScore = MINUS_INF;
+  for(int i=candidates.size()-1; canPrune && i>=0; i--) {
+    ColaScore score = candidates[i].score;
+    if(score<deeperScore && getMatchDepth(candidates[i].depth)+1>=contigScores.getMonotoneDepth()) {
+      candidates[i].score = MINUS_INF; // Not kept
+    }
+    deeperScore = std::max(deeperScore, score);
+  }
+  int numKept = 0;
+  for(int i=0; i<(int)candidates.size(); i++) {
+    if(candidates[i].score==MINUS_INF) { continue; }
+    if(numKept<(int)deepNodes.size()) {
+      deepNodes[numKept] = candidates[i];
+    } else {
+      deepNodes.push_back(candidates[i]);
+    }
+    numKept++;
+  }
+  cur[DEEP_COUNT][r] = numKept;
+  return true;
+}
+
+template<class V, bool AFFINE>
+template<bool ORIGIN>
+bool AntidiagNSkernel<V, AFFINE>::extendRun(const EditGraphDeepNode& parent, int row, int col, bool atCheckpoint) {
+  int depth = parent.depth + 1;
+  long long score = (long long)parent.score + contigScores.getIncrement(getMatchDepth(depth));
+  if(score>=ANTIDIAG_SCORE_LIMIT) { return false; }
+  int cpaRow   = parent.CPA.row;
+  int cpaDepth = parent.CPA.depth;
+  if(ORIGIN) {
+    if(parent.score<=0) {
+      cpaRow   = row;
+      cpaDepth = col;
+    }
+  } else if(atCheckpoint) {
+    cpaRow   = row;
+    cpaDepth = depth;
+  }
+  candidates.push_back(EditGraphDeepNode(depth, (ColaScore)std::max(score, 0LL), cpaRow, cpaDepth));
+  return true;
+}
+
+template<class V, bool AFFINE>
+int AntidiagNSkernel<V, AFFINE>::getBestDepth(int* const* cur, int t, int r) {
+  ColaScore best = cur[BEST][r];
+  for(int d=0; d<EDITGRAPH_BASE_DEPTHS; d++) {
+    if(cur[SCORE+d][r]==best) { return d; }
+  }
+  const vector<EditGraphDeepNode>& deepNodes = getDeepNodes(t, r);
+  for(int i=0; i<cur[DEEP_COUNT][r]; i++) {
+    if(deepNodes[i].score==best) { return deepNodes[i].depth; }
+  }
+  return 0;
+}
+
+template<class V, bool AFFINE>
+void AntidiagNSkernel<V, AFFINE>::keepCell(AntidiagColumn& cells, int* const* cur, int t, int r) {
+  for(int d=0; d<EDITGRAPH_BASE_DEPTHS; d++) {
+    EditGraphCPA cpa;
+    cpa.row   = cur[CPA_ROW+d][r];
+    cpa.depth = cur[CPA_DEPTH+d][r];
+    cells.scores.push_back(cur[SCORE+d][r]);
+    cells.CPAs.push_back(cpa);
+  }
+  cells.deepOffsets.push_back(cells.deepNodes.size());
+  const vector<EditGraphDeepNode>& deepNodes = getDeepNodes(t, r);
+  cells.deepNodes.insert(cells.deepNodes.end(), deepNodes.begin(), deepNodes.begin() + cur[DEEP_COUNT][r]);
+  cells.bestDepths.push_back(getBestDepth(cur, t, r));
+}
+
+#endif //_ANTIDIAGNSKERNEL_H_
@@ -0,0 +1,124 @@
+#ifndef FORCE_DEBUG
+#define NDEBUG
+#endif
+
+#include <algorithm>
+#include <climits>
+#include "BatchSWGA.h"
+#include "SIMDDispatch.h"
+
+//=====================================================================
+/** Used for ordering the targets of a batch by length */
+struct BatchTargetLess
+{
+  BatchTargetLess(const vector<const DNAVector*>& t): targets(t) {}
+  bool operator()(int a, int b) const { return targets[a]->isize() < targets[b]->isize(); }
+  const vector<const DNAVector*>& targets;
+};
+
+/** The largest score kept in lanes of the given width */
+static int getMaxLaneScore(int bits) {
+  switch(bits) {
+    case 8:  return SCHAR_MAX;
+    case 16: return SHRT_MAX;
+    default: return INT_MAX;
+  }
+}
+
+/** The number of distinct bases of a sequence */
+static int getNumBases(const DNAVector& seq) {
+  bool seen[UCHAR_MAX+1] = { false };
+  int numBases = 0;
+  for(int i=0; i<seq.isize(); i++) {
+    unsigned char b = (unsigned char)seq[i];
+    if(!seen[b]) {
+      seen[b] = true;
+      numBases++;
+    }
+  }
+  return numBases;
+}
+
+bool BatchSWGA::isApplicable(const DNAVector& tSeq, const DNAVector& qSeq) const {
+  if(!tSeq.isize() || !qSeq.isize()) { return false; }
+  if(params.getGapOpenP()>0 || params.getGapExtP()>0) { return false; }
+  return fitsPenalties(32);
+}
+
+bool BatchSWGA::fitsPenalties(int bits) const {
+  int maxScore = getMaxLaneScore(bits);
+  int minScore = -maxScore-1;
+  return params.getGapOpenP()>=minScore/2 && params.getGapExtP()>=minScore/2 &&
+         params.getMismatchP()>=minScore/2 && params.getMismatchP()<=maxScore/2;
+}
+
+bool BatchSWGA::fitsLengths(int bits, const DNAVector& tSeq, const DNAVector& qSeq, int numQueryBases) const {
+  switch(bits) {
+    case 8:  return numQueryBases<SCHAR_MAX;
+    case 16: return tSeq.isize()<SHRT_MAX && qSeq.isize()<SHRT_MAX;
+    default: return true;
+  }
+}
+
+bool BatchSWGA::score(const vector<const DNAVector*>& targets, const DNAVector& qSeq,
+                      vector<BatchSWGAscore>& scores) const {
+  SIMDLevel level = getSIMDLevel();
+  if(level==SIMD_SCALAR) { return false; }
+
+  // Targets of similar length share a batch, so that few lanes idle past the end of their target
+  vector<int> order(targets.size());
+  for(int t=0; t<(int)targets.size(); t++) { order[t] = t; }
+  std::stable_sort(order.begin(), order.end(), BatchTargetLess(targets));
+
+  // Each width scores the targets it fits that were not scored by a narrower one or saturated it
+  scores.resize(targets.size());
+  int numQueryBases = getNumBases(qSeq);
+  const int widths[] = { 8, 16, 32 };
+  vector<int> pending, rest;
+  for(int w=0; w<3 && !order.empty(); w++) {
+    int bits = widths[w];
+    if(!fitsPenalties(bits)) { continue; }
+    pending.clear();
+    rest.clear();
+    for(int o=0; o<(int)order.size(); o++) {
+      if(bits==32 || fitsLengths(bits, *targets[order[o]], qSeq, numQueryBases)) {
+        pending.push_back(order[o]);
+      } else {
+        rest.push_back(order[o]);
+      }
+    }
+    if(!scoreBatches(bits, level, targets, pending, qSeq, scores)) { return false; }
+    int maxScore = getMaxLaneScore(bits);
+    for(int p=0; p<(int)pending.size(); p++) {
+      if(bits<32 && scores[pending[p]].score>=maxScore) { rest.push_back(pending[p]); }
+    }
+    // The rest is kept in length order for the next width
+    order.swap(rest);
+    std::stable_sort(order.begin(), order.end(), BatchTargetLess(targets));
+  }
+  return true;
+}
+
+bool BatchSWGA::scoreBatches(int bits, SIMDLevel level, const vector<const DNAVector*>& targets, const vector<int>& order,
+                             const DNAVector& qSeq, vector<BatchSWGAscore>& scores) const {
+  int vecBits = BATCH_SWGA_SSE41_BITS;
+  if(level==SIMD_AVX2)     { vecBits = BATCH_SWGA_AVX2_BITS; }
+  if(level==SIMD_AVX512BW) { vecBits = BATCH_SWGA_AVX512_BITS; }
+  int lanes = vecBits/bits;
+  vector<const DNAVector*> batch;
+  vector<BatchSWGAscore> batchScores;
+  for(int first=0; first<(int)order.size(); first+=lanes) {
+    int last = min((int)order.size(), first+lanes);
+    batch.clear();
+    for(int t=first; t<last; t++) { batch.push_back(targets[order[t]]); }
+    bool done = false;
+    switch(level) {
+      case SIMD_AVX512BW: done = batchSWGAavx512(batch, qSeq, params, bits, batchScores); break;
+      case SIMD_AVX2:     done = batchSWGAavx2(batch, qSeq, params, bits, batchScores);   break;
+      default:            done = batchSWGAsse41(batch, qSeq, params, bits, batchScores);  break;
+    }
+    if(!done) { return false; }
+    for(int t=first; t<last; t++) { scores[order[t]] = batchScores[t-first]; }
+  }
+  return true;
+}
@@ -0,0 +1,99 @@
+#ifndef _BATCHSWGA_H_
+#define _BATCHSWGA_H_
+
+#include "ryggrad/src/general/DNAVector.h"
+#include "AlignerParams.h"
+#include "SIMDDispatch.h"
+
+//=====================================================================
+/**
+ * The best local alignment score of a query against a target and the
+ * node it ends on: the first node holding the score in column (target),
+ * row (query) order, as the best scored node of the aligner traversal.
+ */
+struct BatchSWGAscore
+{
+  BatchSWGAscore(): score(0), targetEnd(-1), queryEnd(-1) {}
+
+  int score;     /// The best local alignment score, 0 if nothing aligns
+  int targetEnd; /// The index of the target base the alignment ends on, -1 if nothing aligns
+  int queryEnd;  /// The index of the query base the alignment ends on, -1 if nothing aligns
+};
+
+//=====================================================================
+/**
+ * Inter-sequence SIMD kernel (after Rognes' SWIPE) scoring one query
+ * against a batch of targets with the SWGA/SW scoring of SWGAaligner:
+ * every lane of the vectors holds a different target, so the cells
+ * of all the lanes are independent and scored in lock step over the query.
+ * Targets are grouped by length to keep the lanes busy. Only scores and end
+ * nodes are found, the alignments themselves are left to the aligners.
+ * The precision adapts to the scores: the targets are first scored in 8-bit
+ * lanes, those whose scores saturate are scored again in 16-bit lanes and
+ * the remaining ones in 32-bit lanes, so most targets get twice the lanes of
+ * a 16-bit kernel. Targets too long or penalties too large for the narrower
+ * lanes start at the width they fit in.
+ * There are kernels per instruction set, compiled separately and selected at
+ * runtime for the CPU (see SIMDDispatch.h), none is used without SSE4.1.
+ */
+class BatchSWGA
+{
+public:
+  BatchSWGA(const AlignerParams& p): params(p) {}
+
+  ~BatchSWGA() {}
+
+  /** Returns true if the parameters and the sequence lengths can be handled by the kernel */
+  bool isApplicable(const DNAVector& tSeq, const DNAVector& qSeq) const;
+
+  /**
+   * Score the query against all the targets.
+   * @param[in]  The targets, all of which must be applicable with the query
+   * @param[in]  The query sequence
+   * @param[out] The score of each target, in the same order
+   * @return false if no kernel is available in this build or for the CPU
+   */
+  bool score(const vector<const DNAVector*>& targets, const DNAVector& qSeq,
+             vector<BatchSWGAscore>& scores) const;
+
+private:
+  /** Returns true if the penalties leave the lanes of the given width headroom for saturating on the sentinel */
+  bool fitsPenalties(int bits) const;
+
+  /**
+   * Returns true if the scores of a target can be kept in lanes of the given width,
+   * as far as the lengths go: positions are kept in the lanes from 16 bits on,
+   * and the bases of the query need to fit in 8-bit lanes.
+   */
+  bool fitsLengths(int bits, const DNAVector& tSeq, const DNAVector& qSeq, int numQueryBases) const;
+
+  /**
+   * Score the given targets in lanes of the given width, batch by batch in the given order
+   * @param[in] level: The instruction set of the kernels
+   * @param[in] order: The indices of the targets to score
+   * @return false if no kernel is available in this build
+   */
+  bool scoreBatches(int bits, SIMDLevel level, const vector<const DNAVector*>& targets, const vector<int>& order,
+                    const DNAVector& qSeq, vector<BatchSWGAscore>& scores) const;
+
+  AlignerParams params; /// The penalties for mismatches and gaps
+};
+
+//=====================================================================
+// The kernels for each instruction set, scoring as many targets as there are lanes
+// of the given width (8, 16 or 32 bits). They return false if they are unavailable in this build.
+bool batchSWGAsse41(const vector<const DNAVector*>& targets, const DNAVector& qSeq,
+                    const AlignerParams& params, int bits, vector<BatchSWGAscore>& scores);
+bool batchSWGAavx2(const vector<const DNAVector*>& targets, const DNAVector& qSeq,
+                   const AlignerParams& params, int bits, vector<BatchSWGAscore>& scores);
+bool batchSWGAavx512(const vector<const DNAVector*>& targets, const DNAVector& qSeq,
+                     const AlignerParams& params, int bits, vector<BatchSWGAscore>& scores);
+
+/** The width of the vectors of the kernels in bits, the number of lanes (targets) is this over the score width */
+#define BATCH_SWGA_SSE41_BITS  128
+#define BATCH_SWGA_AVX2_BITS   256
+#define BATCH_SWGA_AVX512_BITS 512
+/** The profile index of the target bases missing from the query, -1 marks the end of a target */
+#define BATCH_SWGA_NO_BASE -2
+
+#endif //_BATCHSWGA_H_
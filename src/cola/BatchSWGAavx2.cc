@@ -0,0 +1,27 @@
+#ifndef FORCE_DEBUG
+#define NDEBUG
+#endif
+
+// N.B. This file is compiled with AVX2 enabled, the kernel is only called if the CPU supports it
+#include "BatchSWGA.h"
+#include "BatchSWGAkernel.h"
+
+//=====================================================================
+bool batchSWGAavx2(const vector<const DNAVector*>& targets, const DNAVector& qSeq,
+                   const AlignerParams& params, int bits, vector<BatchSWGAscore>& scores) {
+#if defined(__AVX2__)
+  switch(bits) {
+    case 8:
+      batchSWGA<AVX2ops8>(targets, qSeq, params, scores);
+      return true;
+    case 16:
+      batchSWGA<AVX2ops>(targets, qSeq, params, scores);
+      return true;
+    default:
+      batchSWGA<AVX2ops32>(targets, qSeq, params, scores);
+      return true;
+  }
+#else
+  return false;
+#endif
+}
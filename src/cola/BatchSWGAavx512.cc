@@ -0,0 +1,27 @@
+#ifndef FORCE_DEBUG
+#define NDEBUG
+#endif
+
+// N.B. This file is compiled with AVX-512BW enabled, the kernel is only called if the CPU supports it
+#include "BatchSWGA.h"
+#include "BatchSWGAkernel.h"
+
+//=====================================================================
+bool batchSWGAavx512(const vector<const DNAVector*>& targets, const DNAVector& qSeq,
+                     const AlignerParams& params, int bits, vector<BatchSWGAscore>& scores) {
+#if defined(__AVX512BW__)
+  switch(bits) {
+    case 8:
+      batchSWGA<AVX512ops8>(targets, qSeq, params, scores);
+      return true;
+    case 16:
+      batchSWGA<AVX512ops>(targets, qSeq, params, scores);
+      return true;
+    default:
+      batchSWGA<AVX512ops32>(targets, qSeq, params, scores);
+      return true;
+  }
+#else
+  return false;
+#endif
+}
@@ -0,0 +1,134 @@
+#ifndef _BATCHSWGAKERNEL_H_
+#define _BATCHSWGAKERNEL_H_
+
+#include "BatchSWGA.h"
+#include "SIMDops.h"
+
+// N.B. This header should only be included from the translation units of the kernels, see SIMDops.h
+
+//=====================================================================
+/**
+ * Score one query against as many targets as there are lanes, one target per lane.
+ * Columns (target positions) are visited in order and within each column the rows
+ * (query positions), keeping the best and horizontal scores of the previous column
+ * for every row. The scores are those of the SWGAaligner traversal, see
+ * StripedSWGAkernel, lanes past the end of their target are scored as unreachable
+ * diagonals, which cannot improve on their best score. Scores saturate at the
+ * limits of the lanes, a best score of V::MAX_VALUE may be short of the actual one.
+ * The end node is kept in the lanes if they are wide enough for the positions,
+ * otherwise the row is looked up in the column a lane improves its best score on.
+ * @param[in]  Up to V::LANES targets
+ * @param[in]  The query sequence
+ * @param[out] The score of each target
+ */
+template<class V>
+void batchSWGA(const vector<const DNAVector*>& targets, const DNAVector& qSeq,
+               const AlignerParams& params, vector<BatchSWGAscore>& scores) {
+  typedef typename V::vec vec;
+  typedef typename V::elem elem;
+  const int lanes = V::LANES;
+  const int qLen  = qSeq.isize();
+  const bool positionsInLanes = (sizeof(elem)>1);
+  int tLen = 0;
+  for(int k=0; k<(int)targets.size(); k++) { tLen = max(tLen, targets[k]->isize()); }
+
+  // The query bases are mapped to the profile built for each column
+  int baseIdx[UCHAR_MAX+1];
+  for(int c=0; c<=UCHAR_MAX; c++) { baseIdx[c] = BATCH_SWGA_NO_BASE; }
+  vector<int> qIdx(qLen);
+  int numBases = 0;
+  for(int i=0; i<qLen; i++) {
+    unsigned char b = (unsigned char)qSeq[i];
+    if(baseIdx[b] == BATCH_SWGA_NO_BASE) { baseIdx[b] = numBases++; }
+    qIdx[i] = baseIdx[b];
+  }
+  // The target bases of each column across the lanes by their profile, -1 past the end of a target
+  vector<elem> tBases(tLen*lanes, -1);
+  for(int k=0; k<(int)targets.size(); k++) {
+    for(int j=0; j<targets[k]->isize(); j++) { tBases[j*lanes+k] = baseIdx[(unsigned char)(*targets[k])[j]]; }
+  }
+  // Per query base: the diagonal score of each lane and that from an unreachable cell
+  // on the first row or column (1 for a match and unreachable otherwise)
+  vector<elem> profile(2*numBases*lanes);
+
+  // The best and horizontal scores of the previous column, only the
+  // start cell on the first row can be reached before the first column
+  vector<elem> B(qLen*lanes, V::MIN_VALUE), Hz(qLen*lanes, V::MIN_VALUE);
+  for(int k=0; k<lanes; k++) { B[k] = 0; }
+
+  const vec vZero    = V::set1(0);
+  const vec vOne     = V::set1(1);
+  const vec vEnded   = V::set1(-1);
+  const vec vNegInf  = V::set1(V::MIN_VALUE);
+  const vec vGapOpen = V::set1(params.getGapOpenP());
+  const vec vGapExt  = V::set1(params.getGapExtP());
+  const vec vMis     = V::set1(params.getMismatchP());
+  vec vBest    = vZero;
+  vec vBestRow = V::set1(-1);
+  vec vBestCol = V::set1(-1);
+  vector<int> bestRows(lanes, -1), bestCols(lanes, -1);
+
+  for(int j=0; j<tLen; j++) {
+    vec vT    = V::load(&tBases[j*lanes]);
+    vec vDead = V::cmpeq(vT, vEnded);
+    for(int b=0; b<numBases; b++) {
+      vec vMatch = V::cmpeq(vT, V::set1(b));
+      V::store(&profile[2*b*lanes], V::select(vDead, vNegInf, V::select(vMatch, vOne, vMis)));
+      V::store(&profile[(2*b+1)*lanes], V::select(vMatch, vOne, vNegInf));
+    }
+    // The row above the first one cannot be reached
+    vec vDiagB    = vNegInf;
+    vec vV        = vNegInf;
+    vec vAbove    = vNegInf;
+    vec vPrevBest = vBest;
+    for(int i=0; i<qLen; i++) {
+      const int o   = i*lanes;
+      const elem* p = &profile[2*qIdx[i]*lanes];
+      vec vPrevB = V::load(&B[o]);
+      vec vHz = V::max(V::adds(V::load(&Hz[o]), vGapExt), V::adds(vPrevB, vGapOpen));
+      vHz = V::max(vHz, V::select(V::cmpeq(vHz, vNegInf), vNegInf, vZero));
+      vec vD = (i==0 || j==0)? V::load(p+lanes) : vNegInf;
+      vD = V::select(V::cmpeq(vDiagB, vNegInf), vD, V::adds(vDiagB, V::load(p)));
+      vD = V::max(vD, V::select(V::cmpeq(vD, vNegInf), vNegInf, vZero));
+      vV = V::max(V::adds(vV, vGapExt), V::adds(vAbove, vGapOpen));
+      vV = V::max(vV, V::select(V::cmpeq(vV, vNegInf), vNegInf, vZero));
+      vAbove = V::max(V::max(vV, vHz), vD);
+      V::store(&B[o], vAbove);
+      V::store(&Hz[o], vHz);
+      // The first node (in column, row order) with the best score ends the alignment
+      if(positionsInLanes) {
+        vec vBetter = V::cmpgt(vAbove, vBest);
+        vBestRow = V::select(vBetter, V::set1(i), vBestRow);
+        vBestCol = V::select(vBetter, V::set1(j), vBestCol);
+      }
+      vBest  = V::max(vBest, vAbove);
+      vDiagB = vPrevB;
+    }
+    // The first row holding the improved best score of a lane in the column ends its alignment
+    if(!positionsInLanes && !V::allEqual(vBest, vPrevBest)) {
+      elem best[lanes], prevBest[lanes];
+      V::store(best, vBest);
+      V::store(prevBest, vPrevBest);
+      for(int k=0; k<lanes; k++) {
+        if(best[k]==prevBest[k]) { continue; }
+        int i = 0;
+        while(B[i*lanes+k]!=best[k]) { i++; }
+        bestRows[k] = i;
+        bestCols[k] = j;
+      }
+    }
+  }
+
+  elem best[lanes], bestRow[lanes], bestCol[lanes];
+  V::store(best, vBest);
+  V::store(bestRow, vBestRow);
+  V::store(bestCol, vBestCol);
+  scores.resize(targets.size());
+  for(int k=0; k<(int)targets.size(); k++) {
+    scores[k].score     = best[k];
+    scores[k].queryEnd  = positionsInLanes? bestRow[k] : bestRows[k];
+    scores[k].targetEnd = positionsInLanes? bestCol[k] : bestCols[k];
+  }
+}
+
+#endif //_BATCHSWGAKERNEL_H_
@@ -0,0 +1,27 @@
+#ifndef FORCE_DEBUG
+#define NDEBUG
+#endif
+
+// N.B. This file is compiled with SSE4.1 enabled, the kernel is only called if the CPU supports it
+#include "BatchSWGA.h"
+#include "BatchSWGAkernel.h"
+
+//=====================================================================
+bool batchSWGAsse41(const vector<const DNAVector*>& targets, const DNAVector& qSeq,
+                    const AlignerParams& params, int bits, vector<BatchSWGAscore>& scores) {
+#if defined(__SSE4_1__)
+  switch(bits) {
+    case 8:
+      batchSWGA<SSE41ops8>(targets, qSeq, params, scores);
+      return true;
+    case 16:
+      batchSWGA<SSE41ops>(targets, qSeq, params, scores);
+      return true;
+    default:
+      batchSWGA<SSE41ops32>(targets, qSeq, params, scores);
+      return true;
+  }
+#else
+  return false;
+#endif
+}
@@ -4,6 +4,8 @@
 
 #include "Cola.h"
 #include "NSGAaligner.h"
+#include "SWaligner.h"
+#include "BatchSWGA.h"
 
 const AlignmentCola& Cola::createAlignment(const DNAVector& tSeq, const DNAVector& qSeq,
               AlignerParams params) {
@@ -13,25 +15,245 @@ const AlignmentCola& Cola::createAlignment(const DNAVector& tSeq, const DNAVecto
 const AlignmentCola& Cola::createAlignment(const DNAVector& tSeq, const DNAVector& qSeq, AlignerParams params,
                                            int targetStartIdx, int queryStartIdx,
                                             int targetStopIdx, int queryStopIdx) { 
-  IAligner* aligner;
+  ColaWorkspace workspace;
+  createAlignment(workspace, tSeq, qSeq, params, targetStartIdx, queryStartIdx, targetStopIdx, queryStopIdx); 
+  latestAlignment = takeAlignment(workspace);
+  return latestAlignment;
+}
+
+const AlignmentCola& Cola::createAlignment(const DNAVector& tSeq, const DNAVector& qSeq, AlignerParams params,
+                                           double maxP, double minIdent) {
+  ColaWorkspace workspace;
+  createAlignment(workspace, tSeq, qSeq, params, maxP, minIdent);
+  latestAlignment = takeAlignment(workspace);
+  return latestAlignment;
+}
+
+const AlignmentCola& Cola::createAlignment(ColaWorkspace& workspace, const DNAVector& tSeq, const DNAVector& qSeq,
+                                           const AlignerParams& params, int targetStartIdx, int queryStartIdx,
+                                           int targetStopIdx, int queryStopIdx) {
+  IAligner* aligner = getAligner(workspace, tSeq, qSeq, params);
+  if(params.isLocalized() && hasLinearScores(params)) {
+    latestScore = aligner->score(targetStartIdx, queryStartIdx, targetStopIdx, queryStopIdx);
+    return alignLocalized(aligner, latestScore);
+  }
+  return aligner->align(targetStartIdx, queryStartIdx, targetStopIdx, queryStopIdx);
+}
+
+const AlignmentCola& Cola::createAlignment(ColaWorkspace& workspace, const DNAVector& tSeq, const DNAVector& qSeq,
+                                           const AlignerParams& params) {
+  return createAlignment(workspace, tSeq, qSeq, params, 0, 0, tSeq.isize(), qSeq.isize());
+}
+
+const AlignmentCola& Cola::createAlignment(ColaWorkspace& workspace, const DNAVector& tSeq, const DNAVector& qSeq,
+                                           const AlignerParams& params, double maxP, double minIdent) {
+  // Without thresholds nothing can be screened out, the score is taken from the alignment.
+  // The nonlinear scores reward long gapped alignments, which keeps their bounds too loose
+  // for the score-only pass to pay off, so those are also aligned in full.
+  if((maxP>=1 && minIdent<=0) || !hasLinearScores(params)) {
+    const AlignmentCola& algn = createAlignment(workspace, tSeq, qSeq, params);
+    EditGraphNode endNode = algn.getEndNode();
+    latestScore = AlignmentScore();
+    if(algn.getLength()>0 && endNode.getScore()>0) {
+      latestScore = AlignmentScore(endNode.getScore(), algn.getTargetOffset(),
+                                   algn.getQueryOffset(), endNode.getCol(), endNode.getRow());
+    }
+    return algn;
+  }
+  IAligner* aligner = getAligner(workspace, tSeq, qSeq, params);
+  latestScore = aligner->score(0, 0, tSeq.isize(), qSeq.isize());
+  // The bounds of the score-only pass decide if the alignment is worth tracing,
+  // otherwise the alignment of the aligner is left empty
+  if(latestScore.isAligned() && latestScore.getMaxIdentity()>=minIdent &&
+     aligner->getAlignment().calcPValOfScore(latestScore.getMaxSWScore())<=maxP) {
+    if(params.isLocalized()) { return alignLocalized(aligner, latestScore); }
+    return aligner->align(0, 0, tSeq.isize(), qSeq.isize());
+  }
+  return aligner->getAlignment();
+}
+
+bool Cola::hasLinearScores(const AlignerParams& params) const {
+  return (params.getType()==SWGA || params.getType()==SW);
+}
+
+const AlignmentCola& Cola::alignLocalized(IAligner* aligner, const AlignmentScore& box) {
+  if(!box.isAligned()) { return aligner->getAlignment(); }
+  // The first base pair of the alignment is a match, taken diagonally from the start cell
+  // a row and column before it. Matches on the first row are scored from the gap row.
+  return aligner->align(box.targetStart, max(box.queryStart-1, 0), box.targetEnd+1, box.queryEnd+1);
+}
+
+AlignerType Cola::getAlignerClass(const DNAVector& tSeq, const DNAVector& qSeq, const AlignerParams& params) const {
   switch(params.getType()) {
     case NSGA: 
-      aligner = new NSGAaligner(tSeq, qSeq, params);
-      break;
+    case NS: 
+    case SWGA: 
+      return params.getType();
+    case SW: 
+      // Linear gaps need no affine depths, but unbanded graphs are scored
+      // faster by the striped SIMD kernel of SWGAaligner
+      if(params.getGapOpenP()==params.getGapExtP() && params.getBandWidth()>=0 &&
+         params.getBandWidth()<max(tSeq.isize(), qSeq.isize())) {
+        return SW;
+      }
+      return SWGA;
+    default:
+      //TODO error message
+      return NSGA;
+  }
+}
+
+IAligner* Cola::createAligner(AlignerType alignerClass, const DNAVector& tSeq, const DNAVector& qSeq,
+                              const AlignerParams& params) {
+  IAligner* aligner;
+  switch(alignerClass) {
     case NS: 
       aligner = new NSaligner(tSeq, qSeq, params);
       break;
     case SWGA: 
-      aligner = new SWGAaligner(tSeq, qSeq, params);
+      aligner = new SWGAaligner(tSeq, qSeq, params); 
       break;
     case SW: 
-      aligner = new SWGAaligner(tSeq, qSeq, params); 
+      aligner = new SWaligner(tSeq, qSeq, params);
       break;
     default:
-      //TODO error message
       aligner = new NSGAaligner(tSeq, qSeq, params);
   }
-  latestAlignment = aligner->align(targetStartIdx, queryStartIdx, targetStopIdx, queryStopIdx); 
-  delete aligner;
-  return latestAlignment;
+  return aligner;
+}
+
+IAligner* Cola::getAligner(ColaWorkspace& workspace, const DNAVector& tSeq, const DNAVector& qSeq,
+                           const AlignerParams& params) {
+  AlignerType alignerClass = getAlignerClass(tSeq, qSeq, params);
+  IAligner*& aligner = workspace.aligners[alignerClass];
+  if(aligner==NULL) {
+    aligner = createAligner(alignerClass, tSeq, qSeq, params);
+  } else {
+    aligner->reset(tSeq, qSeq, params);
+  }
+  workspace.latestAligner = aligner;
+  return aligner;
+}
+
+AlignmentCola Cola::takeAlignment(ColaWorkspace& workspace) {
+  if(workspace.latestAligner==NULL) { return AlignmentCola(); }
+  return workspace.latestAligner->takeAlignment();
+}
+
+void Cola::createAlignments(const vecDNAVector& targets, const DNAVector& qSeq, AlignerParams params,
+              double maxP, double minIdent, double minScore, vector<ColaBatchResult>& results) {
+  results.clear();
+  results.resize(targets.isize());
+
+  // Targets that the kernel can score are screened together, the others are aligned in full
+  ColaWorkspace workspace;
+  BatchSWGA kernel(params);
+  bool useKernel = isBatchScored(params);
+  vector<const DNAVector*> batch;
+  vector<int> batchIdxs;
+  for(int t=0; t<targets.isize(); t++) {
+    if(useKernel && kernel.isApplicable(targets[t], qSeq)) {
+      batch.push_back(&targets[t]);
+      batchIdxs.push_back(t);
+    } else {
+      screenBatchTarget(workspace, targets[t], qSeq, params, maxP, minIdent, results[t]);
+    }
+  }
+  if(batch.empty()) { return; }
+
+  vector<BatchSWGAscore> scores;
+  bool scored = kernel.score(batch, qSeq, scores);
+  for(int b=0; b<(int)batch.size(); b++) {
+    ColaBatchResult& result = results[batchIdxs[b]];
+    if(!scored) {
+      screenBatchTarget(workspace, *batch[b], qSeq, params, maxP, minIdent, result);
+      continue;
+    }
+    result.score     = scores[b].score;
+    result.targetEnd = scores[b].targetEnd;
+    result.queryEnd  = scores[b].queryEnd;
+    if(scores[b].score>0 && scores[b].score>=minScore) {
+      // The alignment ends on the best scored node, so the graph beyond it need not be visited
+      alignBatchTarget(workspace, *batch[b], qSeq, params, scores[b].targetEnd+1, scores[b].queryEnd+1,
+                       maxP, minIdent, result);
+    }
+  }
+}
+
+BatchSWGAscore Cola::scoreAlignment(const DNAVector& tSeq, const DNAVector& qSeq, const AlignerParams& params) {
+  BatchSWGA kernel(params);
+  vector<BatchSWGAscore> scores;
+  if(isBatchScored(params) && kernel.isApplicable(tSeq, qSeq) &&
+     kernel.score(vector<const DNAVector*>(1, &tSeq), qSeq, scores)) {
+    return scores[0];
+  }
+  ColaWorkspace workspace;
+  return scoreByAligner(workspace, tSeq, qSeq, params);
+}
+
+void Cola::scoreAlignments(const vecDNAVector& targets, const DNAVector& qSeq, const AlignerParams& params,
+              vector<BatchSWGAscore>& scores) {
+  scores.clear();
+  scores.resize(targets.isize());
+
+  // Targets that the kernel can score are scored together, the others by their aligner
+  ColaWorkspace workspace;
+  BatchSWGA kernel(params);
+  bool useKernel = isBatchScored(params);
+  vector<const DNAVector*> batch;
+  vector<int> batchIdxs;
+  for(int t=0; t<targets.isize(); t++) {
+    if(useKernel && kernel.isApplicable(targets[t], qSeq)) {
+      batch.push_back(&targets[t]);
+      batchIdxs.push_back(t);
+    } else {
+      scores[t] = scoreByAligner(workspace, targets[t], qSeq, params);
+    }
+  }
+  if(batch.empty()) { return; }
+
+  vector<BatchSWGAscore> batchScores;
+  bool scored = kernel.score(batch, qSeq, batchScores);
+  for(int b=0; b<(int)batch.size(); b++) {
+    scores[batchIdxs[b]] = scored? batchScores[b] : scoreByAligner(workspace, *batch[b], qSeq, params);
+  }
+}
+
+bool Cola::isBatchScored(const AlignerParams& params) const {
+  return hasLinearScores(params) && params.getBandWidth()<0;
+}
+
+BatchSWGAscore Cola::scoreByAligner(ColaWorkspace& workspace, const DNAVector& tSeq, const DNAVector& qSeq,
+              const AlignerParams& params) {
+  IAligner* aligner = getAligner(workspace, tSeq, qSeq, params);
+  AlignmentScore box = aligner->score(0, 0, tSeq.isize(), qSeq.isize());
+  BatchSWGAscore result;
+  if(box.isAligned()) {
+    result.score     = box.score;
+    result.targetEnd = box.targetEnd;
+    result.queryEnd  = box.queryEnd;
+  }
+  return result;
+}
+
+void Cola::screenBatchTarget(ColaWorkspace& workspace, const DNAVector& tSeq, const DNAVector& qSeq,
+              const AlignerParams& params, double maxP, double minIdent, ColaBatchResult& result) {
+  const AlignmentCola& algn = createAlignment(workspace, tSeq, qSeq, params, maxP, minIdent);
+  result.score     = latestScore.score;
+  result.targetEnd = latestScore.targetEnd;
+  result.queryEnd  = latestScore.queryEnd;
+  result.isHit     = (algn.getLength()>0 && algn.calcPVal()<=maxP && algn.getIdentityScore()>=minIdent);
+  if(result.isHit) { result.alignment = takeAlignment(workspace); }
+}
+
+void Cola::alignBatchTarget(ColaWorkspace& workspace, const DNAVector& tSeq, const DNAVector& qSeq,
+              const AlignerParams& params, int targetStopIdx, int queryStopIdx,
+              double maxP, double minIdent, ColaBatchResult& result) {
+  const AlignmentCola& algn = createAlignment(workspace, tSeq, qSeq, params, 0, 0, targetStopIdx, queryStopIdx);
+  EditGraphNode endNode = algn.getEndNode();
+  result.score     = endNode.getScore();
+  result.targetEnd = endNode.getCol();
+  result.queryEnd  = endNode.getRow();
+  result.isHit     = (algn.calcPVal()<=maxP && algn.getIdentityScore()>=minIdent);
+  if(result.isHit) { result.alignment = takeAlignment(workspace); }
 }
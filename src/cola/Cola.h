@@ -3,9 +3,54 @@
 
 #include "AlignmentCola.h"
 #include "AlignerParams.h"
+#include "IAligner.h"
+#include "BatchSWGA.h"
 
 //=====================================================================
+/**
+ * The outcome of aligning a query against one of the targets of a batch:
+ * the best local alignment score and where it ends for every target, and
+ * the full alignment for the hits, i.e. the targets that pass the thresholds.
+ */
+struct ColaBatchResult
+{
+  ColaBatchResult(): score(0), targetEnd(-1), queryEnd(-1), isHit(false), alignment() {}
 
+  double score;            /// The best local alignment score
+  int targetEnd;           /// The index of the target base the alignment ends on, -1 if nothing aligns
+  int queryEnd;            /// The index of the query base the alignment ends on, -1 if nothing aligns
+  bool isHit;              /// True if the alignment passed the thresholds
+  AlignmentCola alignment; /// The alignment, only set for hits
+};
+
+//=====================================================================
+/**
+ * Aligners kept between alignments so that the buffers of their edit graphs
+ * are reused instead of allocated for every pair, see the createAlignment
+ * overloads of Cola taking a workspace. One aligner is kept per aligner
+ * class, set up for the sequences of each new alignment (IAligner::reset).
+ * A workspace is not thread-safe, each thread should use its own.
+ */
+class ColaWorkspace
+{
+  friend class Cola;
+public:
+  ColaWorkspace(): aligners(SW+1, (IAligner*)NULL), latestAligner(NULL) {}
+
+  ~ColaWorkspace() {
+    for(int i=0; i<(int)aligners.size(); i++) { delete aligners[i]; }
+  }
+
+private:
+  // The aligners are owned by the workspace, so it can not be copied
+  ColaWorkspace(const ColaWorkspace&);
+  ColaWorkspace& operator=(const ColaWorkspace&);
+
+  vector<IAligner*> aligners; /// The aligner of each class, indexed by the type it is used for
+  IAligner* latestAligner;    /// The aligner of the latest alignment
+};
+
+//=====================================================================
 /**
  * Factory class used for obtaining one of the aligner types:
  * NSGAaligner, NSaligner, SWGAaligner, and SWaligner
@@ -22,10 +67,134 @@ public:
   const AlignmentCola& createAlignment(const DNAVector& tSeq, const DNAVector& qSeq,
               AlignerParams params); 
 
+  /**
+   * Align only if the alignment can pass the thresholds. A score-only pass finds
+   * where the best local alignment starts and ends, the recursion and traceback
+   * are skipped if an alignment of that extent can not be significant or
+   * identical enough, in which case the returned alignment is empty. Only the
+   * SWGA/SW aligners are screened, the others are aligned in full.
+   * With localized params the alignment is only traced within the extent
+   * found by the score-only pass (see alignLocalized).
+   * @param[in] maxP: The maximum P-value of an alignment
+   * @param[in] minIdent: The minimum identity of an alignment
+   */
+  const AlignmentCola& createAlignment(const DNAVector& tSeq, const DNAVector& qSeq,
+              AlignerParams params, double maxP, double minIdent);
+
+  /**
+   * The createAlignment variants above using the aligners of the workspace. The
+   * returned alignment is held by the workspace until its next alignment, it
+   * is not copied to the alignment returned by getAlignment (see takeAlignment).
+   * With localized params the given section is first scored (see getScore) and
+   * only the extent of its best local alignment is traced (SWGA/SW, see alignLocalized).
+   * @param[in] workspace: The aligners reused between calls
+   */
+  const AlignmentCola& createAlignment(ColaWorkspace& workspace, const DNAVector& tSeq, const DNAVector& qSeq,
+              const AlignerParams& params, int targetStartIdx, int queryStartIdx, int targetStopIdx, int queryStopIdx);
+
+  const AlignmentCola& createAlignment(ColaWorkspace& workspace, const DNAVector& tSeq, const DNAVector& qSeq,
+              const AlignerParams& params);
+
+  const AlignmentCola& createAlignment(ColaWorkspace& workspace, const DNAVector& tSeq, const DNAVector& qSeq,
+              const AlignerParams& params, double maxP, double minIdent);
+
+  /**
+   * Move the latest alignment created with the workspace out of it, so that it
+   * can be kept past the next alignment without copying it
+   */
+  AlignmentCola takeAlignment(ColaWorkspace& workspace);
+
+  /**
+   * Align a query against a batch of targets. For the SWGA/SW aligners in unbanded
+   * mode the targets are first scored together with the inter-sequence SIMD kernel
+   * (see BatchSWGA) and only those reaching minScore are aligned in full, other
+   * aligners align every target in turn.
+   * @param[in] targets: The target sequences
+   * @param[in] qSeq: The query sequence
+   * @param[in] params: The aligner type and penalties
+   * @param[in] maxP: The maximum P-value of a hit
+   * @param[in] minIdent: The minimum identity of a hit
+   * @param[in] minScore: The minimum local alignment score for a target to be aligned in full
+   * @param[out] results: The result for each target, in the same order
+   */
+  void createAlignments(const vecDNAVector& targets, const DNAVector& qSeq, AlignerParams params,
+              double maxP, double minIdent, double minScore, vector<ColaBatchResult>& results);
+
+  /**
+   * The best local alignment score of a pair and where it ends, without aligning it.
+   * For the SWGA/SW aligners in unbanded mode the pair is scored by the adaptive
+   * precision kernel (see BatchSWGA), otherwise by the score-only pass of the aligner.
+   * N.B. The kernel scores a single pair in one lane, pairs sharing a query are
+   * scored faster together with scoreAlignments.
+   */
+  BatchSWGAscore scoreAlignment(const DNAVector& tSeq, const DNAVector& qSeq, const AlignerParams& params);
+
+  /**
+   * The scoreAlignment of a query against each of a batch of targets, the targets
+   * the kernel can score are scored together
+   * @param[out] scores: The score of each target, in the same order
+   */
+  void scoreAlignments(const vecDNAVector& targets, const DNAVector& qSeq, const AlignerParams& params,
+              vector<BatchSWGAscore>& scores);
+
   AlignmentCola& getAlignment() { return latestAlignment; }
 
+  /** The outcome of the latest score-only pass */
+  const AlignmentScore& getScore() const { return latestScore; }
+
 private:
-  AlignmentCola latestAlignment;
+  /**
+   * The type whose aligner class aligns the sequences with the given params:
+   * the type of the params except for SW, which is aligned by SWGAaligner if
+   * the gaps are affine or the graph unbanded
+   */
+  AlignerType getAlignerClass(const DNAVector& tSeq, const DNAVector& qSeq, const AlignerParams& params) const;
+
+  /** @return pointer to a new aligner of the given class (see getAlignerClass), to be deleted by the caller */
+  IAligner* createAligner(AlignerType alignerClass, const DNAVector& tSeq, const DNAVector& qSeq,
+              const AlignerParams& params);
+
+  /** @return the aligner of the workspace for the sequences, created on first use */
+  IAligner* getAligner(ColaWorkspace& workspace, const DNAVector& tSeq, const DNAVector& qSeq,
+              const AlignerParams& params);
+
+  /**
+   * Whether the score of a path is the sum of the scores of its columns (SWGA/SW). The
+   * contiguity scores of NSGA/NS keep the best node of each cell and depth, which then
+   * depends on the paths reaching the cell, so the alignment of a subsection of the graph
+   * may be worse than the one of the whole graph within it.
+   */
+  bool hasLinearScores(const AlignerParams& params) const;
+
+  /**
+   * Align within the bounding box of the best local alignment found by the score-only pass
+   * of the aligner (see AlignerParams::isLocalized), SWGA/SW only. Every path of the box is one of the graph,
+   * and the path the pass scored lies in it, so the best alignment of the box is as good as
+   * that of the whole graph. It ends on the bottom right cell of the box unless tied.
+   * @param[in] aligner: The aligner the score-only pass was run on
+   * @param[in] box: The outcome of the score-only pass
+   * @return the alignment within the box, empty if nothing aligns
+   */
+  const AlignmentCola& alignLocalized(IAligner* aligner, const AlignmentScore& box);
+
+  /** Whether the batch kernel scores the alignments with the given params (see BatchSWGA) */
+  bool isBatchScored(const AlignerParams& params) const;
+
+  /** Score a pair with the score-only pass of its aligner */
+  BatchSWGAscore scoreByAligner(ColaWorkspace& workspace, const DNAVector& tSeq, const DNAVector& qSeq,
+              const AlignerParams& params);
+
+  /** Align the query against a single target of a batch if it can pass the thresholds */
+  void screenBatchTarget(ColaWorkspace& workspace, const DNAVector& tSeq, const DNAVector& qSeq,
+              const AlignerParams& params, double maxP, double minIdent, ColaBatchResult& result);
+
+  /** Align the query against a single target of a batch and check the thresholds */
+  void alignBatchTarget(ColaWorkspace& workspace, const DNAVector& tSeq, const DNAVector& qSeq,
+              const AlignerParams& params, int targetStopIdx, int queryStopIdx,
+              double maxP, double minIdent, ColaBatchResult& result);
+
+  AlignmentCola  latestAlignment;
+  AlignmentScore latestScore;
 };
 
 #endif //_COLA_H_
@@ -0,0 +1,52 @@
+#ifndef FORCE_DEBUG
+#define NDEBUG
+#endif
+
+#include <climits>
+#include "ContigScoring.h"
+
+
+//=====================================================================
+double ContigScoring::getTotalScore(int depth) const {
+  switch(type) {
+    case EXPONENTIAL_CS:
+      return pow(base, depth) - 1;
+    case USER_CS:
+      if(func != NULL) { return func(depth); }
+      // Fall back to the default without a function
+    case CUBIC_CS:
+    default:
+      return pow(depth/1.0, 3);
+  }
+}
+
+//=====================================================================
+/** The total score rounded to the aligner scores, which saturate at INT_MAX */
+static long long getRoundedTotal(const ContigScoring& scoring, int depth) {
+  double total = scoring.getTotalScore(depth);
+  if(!(total < INT_MAX)) { return INT_MAX; } // Also catches overflow to inf and NaN
+  if(total < INT_MIN)    { return INT_MIN; }
+  return llround(total);
+}
+
+void ContigScoreTable::init(const ContigScoring& scoring, int maxDepth) {
+  increments.resize(maxDepth+1);
+  increments[0] = 0; // No match at depth 0
+  long long prevTotal = getRoundedTotal(scoring, 0);
+  // Past the depth where the totals saturate any run of matches ends at INT_MAX,
+  // which needs the total of no matches to be at most zero
+  bool saturates = (prevTotal<=0);
+  int satDepth   = maxDepth+1;
+  for(int k=1; k<=maxDepth; k++) {
+    long long total = getRoundedTotal(scoring, k);
+    increments[k]   = (int)max(min(total - prevTotal, (long long)INT_MAX), (long long)INT_MIN);
+    prevTotal       = total;
+    if(saturates && total==INT_MAX && satDepth>maxDepth) { satDepth = k; }
+  }
+  // The increments need not grow once the totals have saturated
+  monotoneDepth = maxDepth+1;
+  for(int k=maxDepth; k>=1; k--) {
+    if(increments[k]<0 || (k+1<satDepth && k<maxDepth && increments[k]>increments[k+1])) { break; }
+    monotoneDepth = k;
+  }
+}
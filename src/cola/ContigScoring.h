@@ -0,0 +1,89 @@
+#ifndef _CONTIGSCORING_H_
+#define _CONTIGSCORING_H_
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+/**
+ * Enumeration specifying the shape of the score given to contiguous matches
+ * CUBIC_CS:       k contiguous matches score k^3
+ * EXPONENTIAL_CS: k contiguous matches score base^k - 1
+ * USER_CS:        k contiguous matches score a user supplied function of k
+ */
+enum ContigScoreType { CUBIC_CS, EXPONENTIAL_CS, USER_CS };
+
+/** User supplied contiguity score: the total score of depth contiguous matches */
+typedef double (*ContigScoreFunc)(int depth);
+
+//=====================================================================
+/**
+ * Describes the function used for scoring contiguous matches in the
+ * nonlinear aligners (NSGA and NS). The total score of k contiguous
+ * matches is given by the function, each further match adds the difference
+ * between the totals of its depth and the depth before.
+ */
+class ContigScoring
+{
+public:
+  ContigScoring(ContigScoreType t = CUBIC_CS, double b = 1.5, ContigScoreFunc f = NULL)
+    :type(t), base(b), func(f) {}
+
+  ContigScoreType getType()const { return type; }
+  double          getBase()const { return base; }
+  ContigScoreFunc getFunc()const { return func; }
+
+  /** Returns the total score of depth contiguous matches */
+  double getTotalScore(int depth) const;
+
+private:
+  ContigScoreType type; /// The shape of the scoring function
+  double base;          /// The base of the exponential scoring
+  ContigScoreFunc func; /// The user supplied function if type is USER_CS
+};
+
+//=====================================================================
+/**
+ * The score added by a match at each contiguity depth, precomputed once per
+ * aligner so that no math functions are called when visiting the nodes.
+ * Contiguity can not exceed the length of the shorter sequence, so the
+ * table is no longer than that. Aligner scores are integers, so the totals
+ * are rounded, and saturate at INT_MAX, before taking the differences.
+ */
+class ContigScoreTable
+{
+public:
+  ContigScoreTable(): increments(), monotoneDepth(1) {}
+  /**
+   * @param[in] The scoring function
+   * @param[in] The maximum contiguity depth to be scored
+   */
+  ContigScoreTable(const ContigScoring& scoring, int maxDepth) { init(scoring, maxDepth); }
+
+  void init(const ContigScoring& scoring, int maxDepth);
+
+  /** Returns the score added by the match that reaches the given contiguity depth (>=1) */
+  int getIncrement(int depth) const { return increments[depth]; }
+
+  int getMaxDepth() const { return (int)increments.size()-1; }
+
+  /** Returns the smallest score added by a match at any depth */
+  int getMinIncrement() const {
+    return (increments.size()>1)? *min_element(increments.begin()+1, increments.end()) : 0;
+  }
+
+  /**
+   * Returns the depth from which no match adds less than the match before it, nor
+   * less than zero, up to where the totals saturate. Of two nodes on a run of matches
+   * both at least this deep, the deeper one gains at least as much from the run.
+   */
+  int getMonotoneDepth() const { return monotoneDepth; }
+
+private:
+  vector<int> increments; /// The score added at each depth, indexed by depth
+  int monotoneDepth;      /// The depth from which the increments do not decrease
+};
+
+#endif //_CONTIGSCORING_H_
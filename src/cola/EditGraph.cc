@@ -5,50 +5,174 @@
 #include "EditGraph.h"
 
 //=====================================================================
-void EditGraphNode::setCPACords(EditGraphNode* parent, int midCol) { 
-  if(col == midCol) {
-    CPArow   = row;
-    CPAdepth = depth;
-  } else if(col > midCol) {
-    CPArow   = parent->getCPARow(); 
-    CPAdepth = parent->getCPADepth(); 
+EditGraphNode* EditGraphDepth::getNode(int k) {
+  // Nodes are mostly added in increasing depth
+  if(nodes.empty() || nodes.back().getDepth()<k) {
+    nodes.push_back(EditGraphNode(0, 0, k, MINUS_INF, 0, 0));
+    return &nodes.back();
   }
+  int lo = 0, hi = getSize();
+  while(lo<hi) {
+    int mid = (lo+hi)/2;
+    if(nodes[mid].getDepth()<k) { lo = mid+1; } else { hi = mid; }
+  }
+  if(nodes[lo].getDepth()!=k) {
+    nodes.insert(nodes.begin()+lo, EditGraphNode(0, 0, k, MINUS_INF, 0, 0));
+  }
+  return &nodes[lo];
 }
 
 //=====================================================================
-void EditGraphDepth::init(int row, int col) {
-  for( int depth=0; depth<getSize(); depth++) {
-    EditGraphNode* currNode = getNode(depth);
-    // If a contiguity cell score is MINUS_INF higher levels will be inf for sure
-    if(depth>3 &&  currNode->getScore()==MINUS_INF) { break; }
-    else { currNode->setScore(MINUS_INF); } 
+EditGraphColumn::EditGraphColumn(int qLen, int maxCD, int bandW): numCells(qLen+1),
+  numDepths(min(maxCD, EDITGRAPH_BASE_DEPTHS-1)+1), bandWidth(-1), firstRow(-1),
+  scores(), CPAs(), bestDepths(), deepCounts(), deepNodes() {
+  reset(qLen, bandW);
+}
+
+void EditGraphColumn::reset(int qLen, int bandW) {
+  numCells  = qLen+1;
+  bandWidth = -1;
+  firstRow  = -1;
+  // Only use banded storage if the band and its borders are shorter than the column
+  if(bandW>=0 && 2*bandW+4<numCells) {
+    bandWidth = bandW;
+    numCells  = 2*bandW+4;
+  }
+  bestDepths.assign(numCells, 0);
+  scores.assign(numCells*numDepths, MINUS_INF);
+  CPAs.assign(numCells*numDepths, EditGraphCPA());
+  // The cell lists keep their capacity, so they are refilled without allocation
+  deepCounts.assign(numCells, 0);
+  deepNodes.resize(numCells);
+}
+
+const EditGraphDeepNode* EditGraphColumn::findDeepNode(int row, int depth) const {
+  int cell = getCellIndex(row);
+  int count = deepCounts[cell];
+  if(count==0) { return NULL; }
+  const vector<EditGraphDeepNode>& cellNodes = deepNodes[cell];
+  // A run of matches usually leaves its depths in a cell without gaps
+  int guess = depth - cellNodes[0].depth;
+  if(guess>=0 && guess<count && cellNodes[guess].depth==depth) { return &cellNodes[guess]; }
+  int lo = 0, hi = count;
+  while(lo<hi) {
+    int mid = (lo+hi)/2;
+    if(cellNodes[mid].depth<depth) { lo = mid+1; } else { hi = mid; }
+  }
+  return (lo<count && cellNodes[lo].depth==depth)? &cellNodes[lo] : NULL;
+}
+
+void EditGraphColumn::setDeepNode(int row, int depth, ColaScore score, int cpaRow, int cpaDepth) {
+  int cell = getCellIndex(row);
+  int& count = deepCounts[cell];
+  vector<EditGraphDeepNode>& cellNodes = deepNodes[cell];
+  // Nodes are mostly added in increasing depth
+  int pos = count;
+  if(count>0 && cellNodes[count-1].depth>=depth) {
+    int lo = 0, hi = count;
+    while(lo<hi) {
+      int mid = (lo+hi)/2;
+      if(cellNodes[mid].depth<depth) { lo = mid+1; } else { hi = mid; }
+    }
+    if(cellNodes[lo].depth==depth) {
+      cellNodes[lo] = EditGraphDeepNode(depth, score, cpaRow, cpaDepth);
+      return;
+    }
+    pos = lo;
+  }
+  if(score==MINUS_INF) { return; }
+  if(count==(int)cellNodes.size()) {
+    cellNodes.push_back(EditGraphDeepNode(depth, score, cpaRow, cpaDepth));
+  } else {
+    cellNodes[count] = EditGraphDeepNode(depth, score, cpaRow, cpaDepth);
+  }
+  rotate(cellNodes.begin()+pos, cellNodes.begin()+count, cellNodes.begin()+count+1);
+  count++;
+}
+
+void EditGraphColumn::getCell(int row, int col, EditGraphDepth& cell) const {
+  cell.clear();
+  for(int depth=0; depth<numDepths; depth++) {
+    int idx = getIndex(row, depth);
+    *cell.getNode(depth) = EditGraphNode(row, col, depth, scores[idx], CPAs[idx].row, CPAs[idx].depth);
+  }
+  for(int i=0; i<getNumDeepNodes(row); i++) {
+    const EditGraphDeepNode& node = getDeepNode(row, i);
+    *cell.getNode(node.depth) = EditGraphNode(row, col, node.depth, node.score, node.CPA.row, node.CPA.depth);
+  }
+  cell.setBestDepth(getBestDepth(row));
+}
+
+void EditGraphColumn::setCell(int row, const EditGraphDepth& cell) {
+  initCell(row);
+  for(int i=0; i<cell.getSize(); i++) {
+    const EditGraphNode& node = cell.getNodeAt(i);
+    setNode(row, node.getDepth(), node.getScore(), node.getCPARow(), node.getCPADepth());
   }
+  setBestDepth(row, cell.getBestDepth());
 }
 
+void EditGraphColumn::copyCell(int row, const EditGraphColumn& other) {
+  initCell(row);
+  int cell = getCellIndex(row);
+  int otherCell = other.getCellIndex(row);
+  for(int depth=0; depth<numDepths; depth++) {
+    scores[depth*numCells + cell] = other.scores[depth*other.numCells + otherCell];
+    CPAs[depth*numCells + cell]   = other.CPAs[depth*other.numCells + otherCell];
+  }
+  for(int i=0; i<other.getNumDeepNodes(row); i++) {
+    const EditGraphDeepNode& node = other.getDeepNode(row, i);
+    setDeepNode(row, node.depth, node.score, node.CPA.row, node.CPA.depth);
+  }
+  setBestDepth(row, other.getBestDepth(row));
+}
 
 //=====================================================================
+void EditGraph::reset(int tLen, int qLen, int bandW, bool adaptiveB) {
+  targetLen = tLen;
+  queryLen  = qLen;
+  bandWidth = bandW;
+  for(int i=0; i<(int)columns.size(); i++) { columns[i].reset(qLen+1, bandW); }
+  checkpointCol.reset(qLen+1, bandW);
+  resetBest();
+  //If bandwidth has not been provided, default is to run in unbanded mode
+  if(bandWidth<0) { bandWidth = max(tLen, qLen); }
+  initBandCenters(adaptiveB);
+}
+
 void EditGraph::initCol(int col, int startRow, int endRow) {
-  // Only need to reset nodes that fall within the bandwidth boundaries for banded alignment
-  int start = max(startRow-1, col-bandWidth-1);
-  int end   = min(endRow, col+bandWidth+1);
+  // Only need to reset nodes that fall within the bandwidth boundaries for banded alignment.
+  // The next band is up to two rows lower with adaptive banding, so one more row is read below.
+  int center = getBandCenter(col);
+  int start  = max(startRow-1, center-bandWidth-1);
+  int end    = min(endRow, center+bandWidth+(adaptiveBand? 2 : 1));
+  EditGraphColumn* column = getColumn(col);
+  column->setDiagonal(center);
   for(int row=start; row<=end; row++) {
-    getCell(row, col)->setBestNode(0); //Reset the bestNode index
-    getCell(row, col)->init(row, col);
+    column->initCell(row);
   }
 }
 
-void EditGraph::updateBest(EditGraphNode* bNode) {
-  if(!bNode) { 
-    bestScoredNode.setScore(MINUS_INF);
-  } else if( bNode->getScore() > bestScoredNode.getScore()) {
-    bestScoredNode = *bNode;
+void EditGraph::centerNextBand(int col, int start, int end) {
+  const EditGraphColumn* column = getColumn(col);
+  int center  = getBandCenter(col);
+  int bestRow = center;
+  ColaScore bestScore = (center>=start && center<=end)? column->getBestScore(center) : MINUS_INF;
+  for(int row=start; row<=end; row++) {
+    if(column->getBestScore(row)>bestScore) {
+      bestScore = column->getBestScore(row);
+      bestRow   = row;
+    }
   }
+  // The diagonal of the center goes on one row lower, and is moved a row towards the best cell
+  bandCenters[col+2] = center + 1 + (bestRow>center) - (bestRow<center);
 }
 
 void EditGraph::checkPoint(int col, int maxStartRow, int minEndRow) {
   // Only need to save nodes that fall within the bandwidth boundaries for banded alignment
   EditGraphColumn* colDat = getColumn(col);
+  checkpointCol.setDiagonal(getBandCenter(col));
   for(int row=maxStartRow; row<=minEndRow; row++) {
-    checkpointCol.setCell(row, colDat->getCell(row));
+    checkpointCol.copyCell(row, *colDat);
   }
 }
@@ -3,37 +3,80 @@
 
 #include <limits>
 #include <vector>
-#include "ryggrad/src/general/DNAVector.h" 
+#include <climits>
+#include "ryggrad/src/general/DNAVector.h"
 
-#define MINUS_INF  -numeric_limits<double>::max()
+/** Scores are integers as all the penalties and contiguity rewards are integral */
+typedef int ColaScore;
+
+/** Score of unreachable nodes, it is absorbing under addScore */
+#define MINUS_INF  INT_MIN
+
+/**
+ * Passed in place of the checkpoint column in the score-only pass, where the
+ * checkpoint ancestor fields of a node keep the row and column of the node
+ * its local alignment starts on instead (see EditGraphNode::setOriginCords)
+ */
+#define TRACK_ORIGIN -2
+
+/**
+ * Passed in place of the checkpoint column when a section is visited once keeping
+ * the parent of every node (see TracebackMatrix): the checkpoint ancestor fields
+ * of a node are then taken from its parent, which holds its own coordinates in them
+ */
+#define TRACK_PARENTS -3
+
+/**
+ * The number of contiguity depths kept for every cell of a column, which cover
+ * the gap depths and a first match. Deeper nodes are only reachable on runs of
+ * matches, so they are kept per cell as needed.
+ */
+#define EDITGRAPH_BASE_DEPTHS 4
+
+/**
+ * Add a penalty/reward to a score: unreachable scores stay unreachable
+ * and the others saturate instead of overflowing.
+ */
+inline ColaScore addScore(ColaScore s, int p) {
+  if(s == MINUS_INF) { return MINUS_INF; }
+  long long sum = (long long)s + p;
+  if(sum > INT_MAX)    { return INT_MAX; }
+  if(sum <= MINUS_INF) { return MINUS_INF + 1; }
+  return (ColaScore)sum;
+}
 
 //==================================================================
 /**
  * The nodes in the edit graph are represented by the following class.
- * Every node contains its coordinates (row, col), 
+ * Every node contains its coordinates (row, col),
  *  a score for getting from it to the origin, a pointer
  * to the node which preceeded it in the route from origin to here,
- * and also the number of contiguous matches so far (Note that 
- * this means the number of matches immediately preceding the current 
- * node without having been interrupted by a mismatch or gap - this 
+ * and also the number of contiguous matches so far (Note that
+ * this means the number of matches immediately preceding the current
+ * node without having been interrupted by a mismatch or gap - this
  * number can then be used to calculate the score of contiguous matches
  * and allocate a non-linear (exponential?) score to them.
  * Each node also contains the row index of the checkPointAncestor,
  * which is used for extracting the checkpoint row from the
  * best scored node once the give subgraph has been calculated.
+ * N.B. The edit graph itself does not store nodes, it keeps the node
+ * fields in flat column arenas (see EditGraphColumn). This class is
+ * the value used to read/write a node and to keep nodes on the path.
  **/
 class EditGraphNode
 {
 public:
   EditGraphNode():row(0), col(0), depth(0), score(MINUS_INF),
   CPArow(0), CPAdepth(0) {}
-  int  getRow()               { return row; }
-  int  getCol()               { return col; }
-  int  getDepth()             { return depth; }
-  double getScore()           { return score; }
-  int  getCPARow()            { return CPArow; }
-  int  getCPADepth()          { return CPAdepth; }
-  void setScore(double s)     { score    = s; }
+  EditGraphNode(int r, int c, int d, ColaScore s, int cpaR, int cpaD):row(r), col(c), depth(d),
+  score(s), CPArow(cpaR), CPAdepth(cpaD) {}
+  int  getRow() const         { return row; }
+  int  getCol() const         { return col; }
+  int  getDepth() const       { return depth; }
+  ColaScore getScore() const  { return score; }
+  int  getCPARow() const      { return CPArow; }
+  int  getCPADepth() const    { return CPAdepth; }
+  void setScore(ColaScore s)  { score    = s; }
   void setRow(int r)          { row      = r; }
   void setCol(int c)          { col      = c; }
   void setDepth(int d)        { depth    = d; }
@@ -49,146 +92,318 @@ public:
   /** This function sets the checkpoint ancestor coordinates to those passed via the parent node
    *  Note that this will be no-ops until the iteration has reached the midCol
    */
-  void setCPACords(EditGraphNode* parent, int midCol);
+  void setCPACords(const EditGraphNode& parent, int midCol) {
+    if(col == midCol) {
+      CPArow   = row;
+      CPAdepth = depth;
+    } else if(col > midCol) {
+      CPArow   = parent.getCPARow();
+      CPAdepth = parent.getCPADepth();
+    }
+  }
+  /** In the score-only pass the checkpoint ancestor coordinates keep the row and column
+   *  the local alignment of the node starts on: its own if the parent has no positive score
+   */
+  void setOriginCords(const EditGraphNode& parent) {
+    if(parent.getScore() <= 0) {
+      CPArow   = row;
+      CPAdepth = col;
+    } else {
+      CPArow   = parent.getCPARow();
+      CPAdepth = parent.getCPADepth();
+    }
+  }
+  /** Sets the checkpoint ancestor, or the origin if ORIGIN (i.e. midCol is TRACK_ORIGIN) */
+  template<bool ORIGIN>
+  void setAncestorCords(const EditGraphNode& parent, int midCol) {
+    if(ORIGIN) { setOriginCords(parent); }
+    else       { setCPACords(parent, midCol); }
+  }
 
 private:
   int row;       /// The row index of the cell
   int col;       /// The column index of the cell
   int depth;     /// The number of contiguous matches
-  double score;  /// The score for getting from the origin to this node
+  ColaScore score; /// The score for getting from the origin to this node
   int  CPArow;   /// Checkpoint Ancestor row
-  int  CPAdepth; /// Checkpoint Ancestor depth 
+  int  CPAdepth; /// Checkpoint Ancestor depth
 };
 
 //==================================================================
-/** 
- * The third dimension of the edit graph are represented via this class.
- * Each instance contains all the nodes for a given row column at 
- * various contiguity depths from 0 to maxContigDepth. 
- * This class also holds the record for the node with the maximum score. 
- * This is then used in calculations instead of recalculating each time. 
+/**
+ * The third dimension of the edit graph for a single cell, detached from the graph.
+ * Each instance contains the nodes kept for a given row column at
+ * various contiguity depths, in increasing depth (not every depth has a node).
+ * This class also holds the record for the node with the maximum score.
+ * It is used for passing the checkpointed cell between recursions,
+ * the graph itself keeps its cells in the column arenas.
  */
 class EditGraphDepth
 {
   public:
-    EditGraphDepth(int maxContigDepth, int initScore=MINUS_INF): nodes(), bestNodeIndex(0) { 
+    EditGraphDepth(int maxContigDepth, ColaScore initScore=MINUS_INF): nodes(), bestDepth(0) {
       // Scores are all initialized to minus_inf but there are cases that requre otherwise
       getNode(0)->setScore(initScore);
     }
     ~EditGraphDepth() {}
-    EditGraphNode* getNode(int k) { 
-      if(getSize()<=k) {
-        nodes.push_back(EditGraphNode());
-      }
-      return &nodes[k]; 
-    } 
-    EditGraphNode* getBestNode()  { return getNode(bestNodeIndex); }
-    void setBestNode(int idx)     { bestNodeIndex = idx; } 
-    double getBestScore() { 
-      return getNode(bestNodeIndex)->getScore(); 
+    /** The node at depth k, added as unreachable if the cell has none */
+    EditGraphNode* getNode(int k);
+    /** The i-th node kept, in increasing depth */
+    const EditGraphNode& getNodeAt(int i) const { return nodes[i]; }
+    EditGraphNode* getBestNode()  { return getNode(bestDepth); }
+    int  getBestDepth() const     { return bestDepth; }
+    void setBestDepth(int depth)  { bestDepth = depth; }
+    ColaScore getBestScore() {
+      return getNode(bestDepth)->getScore();
     }
 
     /** Return the number of nodes in the depth */
-    int getSize() { return nodes.size(); }
+    int getSize() const { return nodes.size(); }
 
-    /** Used to initialise a cell depth for the next iteration */
-    void init(int row, int col); 
+    /** Used to remove all nodes so that the cell can be refilled */
+    void clear() { nodes.clear(); bestDepth = 0; }
 
   private:
-    vector<EditGraphNode> nodes; /// Nodes with varying match contiguity depths.
-    int bestNodeIndex;           /// Keep record to be used for scoring neighbouring cells
+    vector<EditGraphNode> nodes; /// Nodes with varying match contiguity depths, in increasing depth
+    int bestDepth;               /// Keep record to be used for scoring neighbouring cells
+};
+
+//==================================================================
+/**
+ * Checkpoint ancestor coordinates of a node as kept in the column arenas
+ */
+struct EditGraphCPA
+{
+  EditGraphCPA(): row(0), depth(0) {}
+  int row;   /// Checkpoint Ancestor row
+  int depth; /// Checkpoint Ancestor depth
 };
 
 //==================================================================
-/** 
- * Each column of the EditGraph contains a vector of EditGraphDepth cells 
+/**
+ * A node at a depth above the base depths as kept in the cell lists of a column
+ */
+struct EditGraphDeepNode
+{
+  EditGraphDeepNode(int d, ColaScore s, int cpaRow, int cpaDepth): depth(d), score(s), CPA() {
+    CPA.row   = cpaRow;
+    CPA.depth = cpaDepth;
+  }
+  int depth;        /// The contiguity depth
+  ColaScore score;  /// The score of the node
+  EditGraphCPA CPA; /// Checkpoint ancestor coordinates
+};
+
+//==================================================================
+/**
+ * Each column of the EditGraph is a single arena holding the node fields of
+ * all its cells as structure-of-arrays: one array for the scores and one for
+ * the checkpoint ancestor coordinates. The arena is laid out as depth planes
+ * for the base depths (EDITGRAPH_BASE_DEPTHS), each plane holding one node per
+ * cell with a fixed stride per depth level, so the coordinates of a node are
+ * implied by its index in the arena and the scan down a column at a given
+ * depth is contiguous. A node above the base depths extends a run of matches
+ * along the diagonal, so only few cells have any, and then only at the depths
+ * the run allows: these are kept in a list per cell, in increasing depth.
+ * The lists keep their capacity, so once they have grown no allocation takes place.
  * This structure is used as the columns in the EditGraph class and also as
  * a container for the checkpoint columns. The column length corresponds
  * to the query length in the alignment + 1 (the addition is for the gap cell).
+ * In banded mode the column only holds the cells of the band, the two
+ * cells bordering it and one more below for an adaptive band moving down
+ * (2*bandWidth+4), indexed relative to the center of the band of the column
+ * it currently represents (see setDiagonal), so its size does not depend on
+ * the sequence lengths.
  */
 class EditGraphColumn
 {
+  friend class TracebackMatrix; // For keeping the parents of a cell as it is visited
 public:
-  EditGraphColumn(int qLen, int maxCD, int initScore=MINUS_INF):cells((qLen+1), EditGraphDepth(maxCD, initScore)) {} 
+  /**
+   * @param[in] qLen: The number of rows in a full column
+   * @param[in] maxCD: The maximum contiguity depth
+   * @param[in] bandW: The bandwidth for banded storage, full length columns are used if negative
+   */
+  EditGraphColumn(int qLen, int maxCD, int bandW=-1);
 
   ~EditGraphColumn() {}
 
   /**
-   * Get a node at given coordinates.
-   * @param[in]  The index in the query sequence
-   * @return The requested node
+   * Set the column up for another number of rows and bandwidth, keeping the allocated memory
+   * @param[in] qLen: The number of rows in a full column
+   * @param[in] bandW: The bandwidth for banded storage, full length columns are used if negative
    */
-  EditGraphNode* getNode(int row, int depth) { return getCell(row)->getNode(depth); }
+  void reset(int qLen, int bandW=-1);
+
+  /** Score of the node at the given row and depth, nodes that are not kept are MINUS_INF */
+  ColaScore getScore(int row, int depth) const {
+    if(depth<numDepths) { return scores[getIndex(row, depth)]; }
+    const EditGraphDeepNode* node = findDeepNode(row, depth);
+    return (node!=NULL)? node->score : MINUS_INF;
+  }
+  int getCPARow(int row, int depth) const   { return getCPA(row, depth).row;   }
+  int getCPADepth(int row, int depth) const { return getCPA(row, depth).depth; }
+
+  /** The number of nodes a cell has above the base depths */
+  int getNumDeepNodes(int row) const { return deepCounts[getCellIndex(row)]; }
+  /** The i-th node of a cell above the base depths, in increasing depth */
+  const EditGraphDeepNode& getDeepNode(int row, int i) const { return deepNodes[getCellIndex(row)][i]; }
+
+  /** Checkpoint ancestor coordinates of a node, cleared ones if it is not kept */
+  EditGraphCPA getCPA(int row, int depth) const {
+    if(depth<numDepths) { return CPAs[getIndex(row, depth)]; }
+    const EditGraphDeepNode* node = findDeepNode(row, depth);
+    return (node!=NULL)? node->CPA : EditGraphCPA();
+  }
 
   /**
-   * Get the EditGraphDepth at the given row position.
-   * Note that row is incremented by 1 to cater for the buffer zone
-   * @param[in]  The row position
-   * @return The requested EditGraphDept
+   * Set the row the band of the column this column currently represents is centered on,
+   * i.e. the column index unless the band is adaptive (see EditGraph::getBandCenter).
+   * This is needed before use in banded mode as the cells are indexed relative to it.
    */
-  EditGraphDepth* getCell(int row) { return &(cells[row+1]); }
+  void setDiagonal(int center) { if(bandWidth>=0) { firstRow = center-bandWidth-1; } }
+
+  /** Store the fields of a node at the given row/depth, unreachable nodes above the base depths are not kept */
+  void setNode(int row, int depth, ColaScore score, int cpaRow, int cpaDepth) {
+    if(depth>=numDepths) {
+      setDeepNode(row, depth, score, cpaRow, cpaDepth);
+      return;
+    }
+    int idx        = getIndex(row, depth);
+    scores[idx]    = score;
+    CPAs[idx].row   = cpaRow;
+    CPAs[idx].depth = cpaDepth;
+  }
+
+  /** The depth of the best scoring node in a cell */
+  int  getBestDepth(int row) const          { return bestDepths[getCellIndex(row)];   }
+  void setBestDepth(int row, int depth)     { bestDepths[getCellIndex(row)] = depth;  }
+  ColaScore getBestScore(int row) const     { return getScore(row, getBestDepth(row)); }
+
+  /** Used to reset a cell for the next iteration */
+  void initCell(int row) {
+    // The checkpoint ancestor is cleared too as in banded mode the cell held another row before.
+    int cell = getCellIndex(row);
+    for(int depth=0; depth<numDepths; depth++) {
+      scores[depth*numCells + cell] = MINUS_INF;
+      CPAs[depth*numCells + cell]   = EditGraphCPA();
+    }
+    deepCounts[cell] = 0;
+    bestDepths[cell] = 0;
+  }
+
+  /**
+   * Get a detached copy of the cell at the given row position.
+   * @param[in] The row position
+   * @param[in] The column position (used for setting the node coordinates)
+   * @param[out] The cell to fill in
+   */
+  void getCell(int row, int col, EditGraphDepth& cell) const;
 
   /**
    * Used for places where a cell needs to be changed. E,g. At the beginning
    * of a recursion iteration where the cell is passed in from previous iteration.
-   * Note that the +1 for the row index is to cater for the gap row.
    */
-  void setCell(int row, const EditGraphDepth& cell) { cells[row+1] = cell; }
-  void setCell(int row, EditGraphDepth* cell) { cells[row+1] = *cell; }
+  void setCell(int row, const EditGraphDepth& cell);
+
+  /** Copy a cell over from another column at the same row */
+  void copyCell(int row, const EditGraphColumn& other);
 
   /** Return the number of cells in the column */
-  int getSize() { return cells.size(); }
+  int getSize() const { return numCells; }
 
+  /** Return the number of base depths kept for every cell */
+  int getNumDepths() const { return numDepths; }
+
+  /** The number of bytes a cell takes in a column with the given number of base depths, its deep nodes aside */
+  static int getCellBytes(int numDepths) {
+    return numDepths*(sizeof(ColaScore)+sizeof(EditGraphCPA)) + 2*sizeof(int) + sizeof(vector<EditGraphDeepNode>);
+  }
 
 private:
-  vector< EditGraphDepth > cells; /// One dimension of the edit graph represented via a vector 
+  /** Note that the first row is -1 in full length columns to cater for the buffer zone */
+  int getCellIndex(int row) const        { return row - firstRow; }
+  int getIndex(int row, int depth) const { return depth*numCells + getCellIndex(row); }
+
+  /** The node of a cell above the base depths, NULL if it is not kept */
+  const EditGraphDeepNode* findDeepNode(int row, int depth) const;
+
+  /** Store a node above the base depths in the list of its cell */
+  void setDeepNode(int row, int depth, ColaScore score, int cpaRow, int cpaDepth);
+
+  int numCells;                 /// The number of cells in the column, also the stride of a depth plane
+  int numDepths;                /// The number of base depth planes
+  int bandWidth;                /// The bandwidth in banded mode, -1 for full length columns
+  int firstRow;                 /// The row held by the first cell of the column
+  vector<ColaScore>    scores;  /// Node scores, one plane per base depth
+  vector<EditGraphCPA> CPAs;    /// Node checkpoint ancestor coordinates, one plane per base depth
+  vector<int>    bestDepths;    /// The depth of the best node of each cell
+  vector<int>    deepCounts;    /// The number of nodes each cell has above the base depths
+  vector< vector<EditGraphDeepNode> > deepNodes; /// The nodes above the base depths of each cell, only the first deepCounts are kept
 };
 
 
 //==================================================================
 // Forward Declaration
-class NSaligner; 
-class SWGAaligner; 
+class NSaligner;
+class SWGAaligner;
 //==================================================================
-/** 
+/**
  * The edit graph of the dynamic programming for the alignment
- * has two dimensions. Every cell contains a vector of nodes, 
+ * has two dimensions. Every cell contains a vector of nodes,
  * each representing the node for the given cell position and
- * at a specific match contiguity depth. Using the check-point 
+ * at a specific match contiguity depth. Using the check-point
  * method only two columns of the graph are kept at any one time.
  * This is more space efficient than keeping the whole matrix
- * but it requires checkpointing (explained in algorithm methodology). 
+ * but it requires checkpointing (explained in algorithm methodology).
  */
 class EditGraph
 {
   friend class NSaligner;
   friend class SWGAaligner;
 public:
-  EditGraph(int tLen, int qLen, int maxCD, int bandW):
-    targetLen(tLen), queryLen(qLen), maxContigDepth(maxCD), 
-    bandWidth(bandW), columns(2, EditGraphColumn(qLen+1, maxCD)),
-    checkpointCol(qLen+1, maxCD), bestScoredNode() {
+  EditGraph(int tLen, int qLen, int maxCD, int bandW, bool adaptiveB=false):
+    targetLen(tLen), queryLen(qLen), maxContigDepth(maxCD),
+    bandWidth(bandW), columns(2, EditGraphColumn(qLen+1, maxCD, bandW)),
+    checkpointCol(qLen+1, maxCD, bandW), bestScoredNode(), adaptiveBand(false), bandCenters() {
     //If bandwidth has not been provided, default is to run in unbanded mode
-    if(bandWidth<0) { bandWidth = max(tLen, qLen); } 
-  } 
+    if(bandWidth<0) { bandWidth = max(tLen, qLen); }
+    initBandCenters(adaptiveB);
+  }
 
   ~EditGraph() {}
 
+  /** Set the graph up for other sequence lengths and bandwidth, keeping the allocated memory */
+  void reset(int tLen, int qLen, int bandW, bool adaptiveB=false);
+
   /**
    * Get a node at given coordinates.
    * @param[in]  The index in the target sequence
    * @param[in]  The index in the query sequence
    * @return The requested node
    */
-  EditGraphNode* getNode(int row, int col, int depth) { 
-    return getCell(row, col)->getNode(depth); }
+  EditGraphNode getNode(int row, int col, int depth) const {
+    const EditGraphColumn* column = getColumn(col);
+    EditGraphCPA cpa = column->getCPA(row, depth);
+    return EditGraphNode(row, col, depth, column->getScore(row, depth), cpa.row, cpa.depth);
+  }
+  ColaScore getScore(int row, int col, int depth) const { return getColumn(col)->getScore(row, depth); }
+
+  /** Store a node in the graph at its own coordinates */
+  void setNode(const EditGraphNode& node) {
+    getColumn(node.getCol())->setNode(node.getRow(), node.getDepth(), node.getScore(),
+                                      node.getCPARow(), node.getCPADepth());
+  }
 
   /**
    * Get the column that pertains to a column index
-   * Note that the modular function is used based on the checkpointing algo 
+   * Note that the modular function is used based on the checkpointing algo
    */
   EditGraphColumn* getColumn(int col) {
-    return &(columns[((col+1)%2)]);  
+    return &(columns[((col+1)%2)]);
+  }
+  const EditGraphColumn* getColumn(int col) const {
+    return &(columns[((col+1)%2)]);
   }
 
   /**
@@ -197,54 +412,100 @@ public:
    * @param[in] col: The col position of the cell
    * @return The node with the best score at the given coordinates
    */
-  EditGraphNode* getBestNodeAtRowCol(int row, int col) { return getCell(row, col)->getBestNode(); }
-  void setBestNodeAtRowCol(int row, int col, int depthIdx) { 
-    getCell(row, col)->setBestNode(depthIdx); 
+  EditGraphNode getBestNodeAtRowCol(int row, int col) const {
+    return getNode(row, col, getColumn(col)->getBestDepth(row));
+  }
+  void setBestNodeAtRowCol(int row, int col, int depthIdx) {
+    getColumn(col)->setBestDepth(row, depthIdx);
   }
-  double getBestScoreAtRowCol(int row, int col) { return getCell(row, col)->getBestScore(); }
+  ColaScore getBestScoreAtRowCol(int row, int col) const { return getColumn(col)->getBestScore(row); }
 
   /**
    * Checks the current best and if the given node is better
-   * the old one is deleted and replaced by the new one.
-   * This function can also be used for resetting the bestNode
-   * by passing Null as the bNode parameter
+   * the old one is replaced by the new one. Saturated scores can not be
+   * told apart, so of those the last one is kept to not cut the alignment short.
    */
-  void updateBest(EditGraphNode* bNode); 
-  
-  /** 
-   * Get the nodes at row,col 
-   * Note that this function takes into consideration the fact
-   * that only two columns of the EditGraph are being kept at
-   * at any one time and hence it modulates the given column number by 2.
-   * Also considers that the editGraph has been padded by an extra row
-   * so passing indexes of -1 also works (all indexes are incremented by 1).
+  void updateBest(const EditGraphNode& bNode) {
+    if(bNode.getScore() > bestScoredNode.getScore() || bNode.getScore() == INT_MAX) { bestScoredNode = bNode; }
+  }
+  /**
+   * Takes the best node found over another part of the graph and keeps the one
+   * updateBest would have kept had all the nodes been visited column by column
    */
-  EditGraphDepth* getCell(int row, int col) { return getColumn(col)->getCell(row); }
- 
+  void mergeBest(const EditGraphNode& bNode) {
+    bool isLater = bNode.getCol()>bestScoredNode.getCol() ||
+                   (bNode.getCol()==bestScoredNode.getCol() && bNode.getRow()>bestScoredNode.getRow());
+    if(bNode.getScore() > bestScoredNode.getScore() ||
+       (bNode.getScore() == bestScoredNode.getScore() && isLater == (bNode.getScore() == INT_MAX))) {
+      bestScoredNode = bNode;
+    }
+  }
+  /** Used for resetting the bestNode */
+  void resetBest() { bestScoredNode.setScore(MINUS_INF); }
+
   /**
    * Checks if a given cell (row, column) of the graph
    * is within the graphs bandWidth (for banded alignment)
    */
-  bool isInBand(int row, int col) { return (abs(row-col)<=bandWidth); }
-  bool isOnBandBorder(int row, int col) { return (abs(row-col)==(bandWidth+1)); }
+  bool isInBand(int row, int col) { return (abs(row-getBandCenter(col))<=bandWidth); }
+  /** Returns true if the band excludes any cell of the graph */
+  bool isBanded() const { return bandWidth<max(targetLen, queryLen); }
+  bool isOnBandBorder(int row, int col) { return (abs(row-getBandCenter(col))==(bandWidth+1)); }
+
+  /** The row the band of a column is centered on: the main diagonal, or the one set by centerNextBand */
+  int getBandCenter(int col) const { return adaptiveBand? bandCenters[col+1] : col; }
+  /** Set the band center of a column */
+  void setBandCenter(int col, int center) { if(adaptiveBand) { bandCenters[col+1] = center; } }
+  /**
+   * Start the band of the first run from the start column, on the diagonal of the cell right of the start
+   * cell, i.e. the main diagonal for the whole graph. The next column is set too, as it is not centered
+   * by the run (see centerNextBand).
+   */
+  void startBand(int startRow, int startCol) {
+    setBandCenter(startCol, startRow-1);
+    setBandCenter(startCol+1, startRow);
+  }
+  /** Whether the band follows the best scoring diagonal (see centerNextBand) */
+  bool isAdaptiveBand() const { return adaptiveBand; }
+  /** Take the band centers from the first run over another graph of the same sequences */
+  void copyBandCenters(const EditGraph& other) { bandCenters = other.bandCenters; }
+
+  /**
+   * Adaptive banding: center the band of the column after the given one on the diagonal of its
+   * best scored cell, moving at most a row either way from the diagonal of its own center so that
+   * the cells read from the given column are in its storage. The cell on the center is kept on ties.
+   * The centers are set by the run finding the best node and taken by the recursion.
+   * @param[in] col: The column just visited
+   * @param[in] start, end: The rows visited in the column
+   */
+  void centerNextBand(int col, int start, int end);
 
 protected:
   /** Used to initialize a column for the next iteration */
   void initCol(int col, int startRow, int endRow);
 
-  /** Used to keep the checkpoint column updated so that the checkpointed node can be found. 
-      This function does not copy the entire column as it might be that in the banded case and 
+  /** Used to keep the checkpoint column updated so that the checkpointed node can be found.
+      This function does not copy the entire column as it might be that in the banded case and
       also with smaller recursions the whole column is not needed.
-  **/ 
-  void checkPoint(int col, int maxStartRow, int minEndRow); 
+  **/
+  void checkPoint(int col, int maxStartRow, int minEndRow);
 
   int targetLen;                   /// The number of characters ie target sequence
   int queryLen;                    /// The number of characters in the query sequence
   int maxContigDepth;              /// The maximum contiguity depth to be considered for scoring
   int bandWidth;                   /// The width of the band for banded smith-waterman
-  vector<EditGraphColumn> columns; /// Two columns of the EditGraph kept at any one instance 
+  vector<EditGraphColumn> columns; /// Two columns of the EditGraph kept at any one instance
   EditGraphColumn checkpointCol;   /// Column used for checkpointing
   EditGraphNode bestScoredNode;    /// The node with the best score, used for tracing local alignment
+  bool adaptiveBand;               /// Whether the band follows the best scoring diagonal instead of the main one
+  vector<int> bandCenters;         /// The band center of each column from -1 in adaptive banding, set by the first run
+
+private:
+  /** Adaptive banding only applies if the band excludes any cell */
+  void initBandCenters(bool adaptiveB) {
+    adaptiveBand = adaptiveB && isBanded();
+    bandCenters.assign(adaptiveBand? targetLen+2 : 0, 0);
+  }
 };
 
 #endif //_EDITGRAPH_H_
@@ -18,9 +18,27 @@ public:
   virtual const AlignmentCola& align() = 0;
   virtual const AlignmentCola& align(int targetStartIdx, int queryStartIdx, int targetStopIdx, int queryStopIdx) = 0;
 
+  /**
+   * Score-only pass: find the best local alignment score and where the
+   * alignment starts and ends without the recursion and traceback of align.
+   */
+  virtual AlignmentScore score(int targetStartIdx, int queryStartIdx, int targetStopIdx, int queryStopIdx) = 0;
+
+  /**
+   * Set the aligner up for other sequences and parameters so that it can be
+   * reused, keeping the buffers allocated by the previous alignments
+   */
+  virtual void reset(const DNAVector& tSeq, const DNAVector& qSeq, const AlignerParams& p) = 0;
+
   /** Returns the alignment object which contains the alignment strings and info **/
   virtual const AlignmentCola& getAlignment() = 0;
 
+  /**
+   * Moves the alignment out of the aligner so that it can be kept without copying
+   * it, the aligner is left with an empty alignment until it aligns again
+   */
+  virtual AlignmentCola takeAlignment() = 0;
+
   /** Returns the target sequence used for the alignment */
   virtual const DNAVector& getTargetSeq() = 0; 
 
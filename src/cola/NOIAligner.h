@@ -51,7 +51,8 @@ private:
   AlignmentSet alignments;    /// Object containing the noneoverlapping alignments
   AlignerParams aligner;      /// Object containing aligner type and relevant parameters
 
-  void recurseAlign(int targetStart, int targetStop, int queryStart, int queryStop); 
+  /** Align the given region and recurse on the regions before and after the alignment, reusing the aligners */
+  void recurseAlign(ColaWorkspace& workspace, int targetStart, int targetStop, int queryStart, int queryStop); 
 };
 
 
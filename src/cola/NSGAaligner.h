@@ -5,6 +5,7 @@
 
 class NSGAaligner: public SWGAaligner 
 {
+  friend class NSaligner; // For visiting the nodes in traverseColumns
 public:
   /** 
    * @param[in]  The target  sequence
@@ -19,11 +20,30 @@ public:
   ~NSGAaligner() {}
 
 protected:
+  /** Returns a copy of this aligner (see NSaligner::clone) */
+  virtual NSaligner* clone() const { return new NSGAaligner(*this); }
+
+  /**
+   * The striped kernel of SWGAaligner only scores linear matches, the
+   * anti-diagonal kernel or the node by node traversal are used as in NSaligner
+   */
+  virtual double visitColumns(int startRow, int startCol, int endRow, int endCol,
+       int currCheckpointColIndex, bool findBestNode);
+
+  /** Matches are scored by contiguity as in NSaligner */
+  virtual int getMinMatchScore() const { return NSaligner::getMinMatchScore(); }
+
+  /** The sections are traced or scored by the anti-diagonal kernel as in NSaligner */
+  virtual bool isTraced(int startRow, int startCol, int endRow, int endCol) const {
+    return NSaligner::isTraced(startRow, startCol, endRow, endCol);
+  }
+
   /** 
-   * Overrides the visitNode function in the parent class
+   * Hides the visitNode function in the parent class
    * @param[in]  The node to be visited 
    * @param[in] Index of column that should be checkpointed in current iteration
    */
+  template<bool ORIGIN>
   void visitNode(EditGraphNode* currNode, int currCheckpointColIndex); 
   
   /**
@@ -31,7 +51,11 @@ protected:
    * from the visitNode function inherited from SWGAligner
    * The nodes visited by this function include all the different diagonal move options
    */
+  template<bool ORIGIN>
   void visitNodeCola(EditGraphNode* currNode, int  currCheckpointColIndex); 
+
+  /** Hides the one in NSaligner, the first two depths are the affine gaps */
+  static int getMatchDepth(int depth) { return depth-2; }
 };
 
 
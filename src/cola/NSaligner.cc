@@ -4,6 +4,8 @@
 
 #include "NSaligner.h"
 
+// The smallest number of cells in both halves of the recursion for visiting them on separate threads
+#define RECURSION_MIN_CELLS (1<<18)
 
 //=====================================================================
 const AlignmentCola& NSaligner::align() {
@@ -14,6 +16,8 @@ const AlignmentCola& NSaligner::align(int targetStartIdx, int queryStartIdx, int
   // No alignment can be performed if any of the query or target sequences are of 0 size
   if(!alignment.getTargetSeq().isize() || !alignment.getQuerySeq().isize()) { return alignment; } 
   double runtime = time(NULL);
+  // The path has at most a node per anti-diagonal of the section
+  alignment.reservePath(targetStopIdx-targetStartIdx + queryStopIdx-queryStartIdx + 1);
   EditGraphDepth startPoint =  EditGraphDepth(editGraph.maxContigDepth, 0);
   double colaRuntimeFactor = traverseGraph(queryStartIdx, targetStartIdx-1, queryStopIdx-1, targetStopIdx-1,
                           -1, startPoint);
@@ -24,17 +28,52 @@ const AlignmentCola& NSaligner::align(int targetStartIdx, int queryStartIdx, int
   return alignment;
 }
 
+AlignmentScore NSaligner::score(int targetStartIdx, int queryStartIdx, int targetStopIdx, int queryStopIdx) {
+  if(!alignment.getTargetSeq().isize() || !alignment.getQuerySeq().isize()) { return AlignmentScore(); } 
+  // Same start as the first run of traverseGraph
+  int startRow = queryStartIdx;
+  int startCol = targetStartIdx-1;
+  int endRow   = queryStopIdx-1;
+  editGraph.startBand(startRow, startCol);
+  editGraph.initCol(startCol, startRow, endRow);
+  editGraph.getColumn(startCol)->setCell(startRow, EditGraphDepth(editGraph.maxContigDepth, 0)); 
+  editGraph.resetBest();
+  visitColumns(startRow, startCol, endRow, targetStopIdx-1, TRACK_ORIGIN, true);
+  const EditGraphNode& best = editGraph.bestScoredNode;
+  if(best.getScore()<=0) { return AlignmentScore(); }
+  AlignmentScore result(best.getScore(), best.getCPADepth(), best.getCPARow(), best.getCol(), best.getRow());
+  int maxCost = -min(min(params.getGapOpenP(), params.getGapExtP()), params.getMismatchP());
+  result.setScoreBound(getMinMatchScore(), maxCost);
+  return result;
+}
+
+void NSaligner::reset(const DNAVector& tSeq, const DNAVector& qSeq, const AlignerParams& p) {
+  editGraph.reset(tSeq.isize(), qSeq.isize(), p.getBandWidth(), p.isAdaptiveBand());
+  alignment.reset(tSeq, qSeq, p);
+  params = p;
+  contigScores.init(p.getContigScoring(), min(editGraph.maxContigDepth, min(tSeq.isize(), qSeq.isize())));
+  threadBudget = p.getNumThreads();
+  // The workers are kept along with their buffers
+  for(int i=0; i<(int)wavefrontWorkers.size(); i++) { wavefrontWorkers[i]->reset(tSeq, qSeq, p); }
+  for(int i=0; i<(int)recursionWorkers.size(); i++) { recursionWorkers[i]->reset(tSeq, qSeq, p); }
+}
+
 double NSaligner::traverseGraph(int startRow, int startCol, int endRow, int endCol,
       int endDepth, const EditGraphDepth& prevCheckpointedCell) {
-  double meanContigDepth = 0;
-  EditGraphNode* currNode;
   // 1) The previously checkpointed cell should be set in its right place in the editGraph:
-  // The place for this is given by the startRow and StartCol parameters
+  // The place for this is given by the startRow and StartCol parameters.
+  // An adaptive band starts on the diagonal of the start cell, the first run centers the others.
+  if(endDepth==-1) { editGraph.startBand(startRow, startCol); }
   editGraph.initCol(startCol, startRow, endRow);
   editGraph.getColumn(startCol)->setCell(startRow, prevCheckpointedCell); 
 
   // 2) Reset the bestScoredNode
-  editGraph.updateBest(NULL);
+  editGraph.resetBest();
+
+  // Sections whose node parents fit in memory are not checkpointed, their path is traced back
+  if(isTraced(startRow, startCol, endRow, endCol)) {
+    return traceGraph(startRow, startCol, endRow, endCol, endDepth);
+  }
 
   // 3) The middle column should be checkpointed
   int currCheckpointColIndex = (startCol + endCol)/2;
@@ -43,44 +82,18 @@ double NSaligner::traverseGraph(int startRow, int startCol, int endRow, int endC
   // top most left node, moving vertically and to the right.
   // For this we start from the the column after the startCol
   // where the cell from previous calculations was set for restarting
-  // calculations (hence the startCol+1 starting point below)
-  for ( int col=startCol+1; col<=endCol; col++ ) {
-    //Reset column
-    editGraph.initCol(col, startRow, endRow); 
-    //banded alignment - skip out-of-band cells
-    int start = max(startRow, col-editGraph.bandWidth);
-    int end   = min(endRow, col+editGraph.bandWidth);
-    for ( int row=start; row<=end; row++ ) {
-      int depth = 0;
-      for ( depth; depth<=editGraph.maxContigDepth; depth++) {
-        currNode = editGraph.getNode(row, col, depth);
-        currNode->setCoords(row, col, depth); 
-        visitNode(currNode, currCheckpointColIndex);
-        if( currNode->getScore() == MINUS_INF && depth>2 ) { break; } //No need to search higher depths
-       // (Step 4a) Update the current best node accordingly
-        editGraph.updateBest(currNode);
-        // (Step 4b) Set the best node for the current cell position
-        if( currNode->getScore() > editGraph.getBestScoreAtRowCol(row, col)) { 
-          editGraph.setBestNodeAtRowCol(row, col, currNode->getDepth()); 
-        }
-        // (Step 4c) For local alignment, if score is negative, set to zero 
-        if(currNode->getScore()!=MINUS_INF && currNode->getScore()<0) {
-          currNode->setScore(0);
-        }
-      }
-      meanContigDepth += depth;
-    }
-    //Checkpoint middle column - keep for retrieving the checkpoint cell
-    if(col == currCheckpointColIndex){ 
-      editGraph.checkPoint(col, start, end);
-    }
-  }
+  // calculations
+  double meanContigDepth = visitColumns(startRow, startCol, endRow, endCol,
+                      currCheckpointColIndex, endDepth==-1);
   meanContigDepth /= (endRow*endCol);
 
   // 5) Check if reached end of recursion  
   if(startCol+1 == endCol) { 
-    // If not at col 0, add to optimal path all the nodes on the column between the start and end row.
-    if(endCol!=0) {
+    // A local alignment within a single column is its best scored match alone,
+    // otherwise, if not at col 0, add to optimal path all the nodes on the column between the start and end row.
+    if(endDepth==-1) {
+      if(editGraph.bestScoredNode.getScore()>0) { alignment.addNodeToPath(editGraph.bestScoredNode); }
+    } else if(endCol!=0) {
       for(int i=startRow+1; i<endRow; i++) { 
         alignment.addNodeToPath(editGraph.getBestNodeAtRowCol(i, endCol)); 
       }
@@ -92,8 +105,8 @@ double NSaligner::traverseGraph(int startRow, int startCol, int endRow, int endC
   int optimalRow, optimalDepth;
 
   if(endDepth!=-1) { 
-    optimalRow   = editGraph.getNode(endRow, endCol, endDepth)->getCPARow();
-    optimalDepth = editGraph.getNode(endRow, endCol, endDepth)->getCPADepth();
+    optimalRow   = editGraph.getColumn(endCol)->getCPARow(endRow, endDepth);
+    optimalDepth = editGraph.getColumn(endCol)->getCPADepth(endRow, endDepth);
   } else { //endDepth is set to -1 in the first run of the function as it's not known
     optimalRow   = editGraph.bestScoredNode.getCPARow();
     optimalDepth = editGraph.bestScoredNode.getCPADepth();
@@ -102,7 +115,7 @@ double NSaligner::traverseGraph(int startRow, int startCol, int endRow, int endC
     endCol       = editGraph.bestScoredNode.getCol();
     endDepth     = editGraph.bestScoredNode.getDepth();
     // Add the targetNode to the path as this will not be added later
-    alignment.addNodeToPath(&(editGraph.bestScoredNode));
+    alignment.addNodeToPath(editGraph.bestScoredNode);
     // If the best scoring node falls before the first checkpointed column:
     // Rerun function and do not continue to step 7-9 
     if(endCol<currCheckpointColIndex) {
@@ -115,17 +128,42 @@ double NSaligner::traverseGraph(int startRow, int startCol, int endRow, int endC
     }
   }
   // 7) First copy the checkpoint cell to be passed to next recursion
-  EditGraphDepth currCheckpointCell = *(editGraph.checkpointCol.getCell(optimalRow));
+  EditGraphDepth currCheckpointCell(editGraph.maxContigDepth);
+  editGraph.checkpointCol.getCell(optimalRow, currCheckpointColIndex, currCheckpointCell);
 
   // 8) Then save node on the optimal path
-  alignment.addNodeToPath(currCheckpointCell.getNode(optimalDepth));
+  alignment.addNodeToPath(*currCheckpointCell.getNode(optimalDepth));
 
   // 9) Continue recursion
-  if ((startCol+1<currCheckpointColIndex ) || (startCol+1==currCheckpointColIndex && startRow<=optimalRow)) {
+  bool visitFirstHalf  = (startCol+1<currCheckpointColIndex ) || (startCol+1==currCheckpointColIndex && startRow<=optimalRow);
+  bool visitSecondHalf = (currCheckpointColIndex+1<endCol ) || (currCheckpointColIndex+1==endCol && optimalRow<=endRow);
+  double firstHalfCells  = (double)(optimalRow-startRow+1) * (currCheckpointColIndex-startCol);
+  double secondHalfCells = (double)(endRow-optimalRow+1) * (endCol-currCheckpointColIndex);
+  if(visitFirstHalf && visitSecondHalf && threadBudget>1 && min(firstHalfCells, secondHalfCells)>=RECURSION_MIN_CELLS) {
+    // The halves only share the checkpoint cell, so the second is visited on another thread
+    // with half of the threads. Its path nodes come after those of the first half.
+    NSaligner* worker = getRecursionWorker(numForks++);
+    if(editGraph.isAdaptiveBand()) { worker->editGraph.copyBandCenters(editGraph); }
+    int budget = threadBudget;
+    worker->threadBudget = budget/2;
+    threadBudget = budget - budget/2;
+    thread secondHalf([&]() {
+      worker->traverseGraph(optimalRow, currCheckpointColIndex, endRow,
+         endCol, endDepth, currCheckpointCell);
+    });
+    traverseGraph(startRow, startCol, optimalRow, currCheckpointColIndex,
+         optimalDepth, prevCheckpointedCell);
+    secondHalf.join();
+    numForks--;
+    threadBudget = budget;
+    alignment.takePathNodes(worker->alignment);
+    return meanContigDepth;
+  }
+  if (visitFirstHalf) {
     traverseGraph(startRow, startCol, optimalRow, currCheckpointColIndex,
          optimalDepth, prevCheckpointedCell);
   }  
-  if ((currCheckpointColIndex+1<endCol ) || (currCheckpointColIndex+1==endCol && optimalRow<=endRow)){
+  if (visitSecondHalf){
     traverseGraph(optimalRow, currCheckpointColIndex, endRow,
        endCol, endDepth, currCheckpointCell);
   } 
@@ -133,43 +171,158 @@ double NSaligner::traverseGraph(int startRow, int startCol, int endRow, int endC
   return meanContigDepth;
 }
 
+double NSaligner::traceGraph(int startRow, int startCol, int endRow, int endCol, int endDepth) {
+  // The start cell holds its own coordinates, the nodes of the section take those of their parents
+  traceback.reset(startCol, editGraph.getColumn(startCol)->getNumDepths());
+  traceback.reserve(getNumSectionCells(startRow, startCol, endRow, endCol));
+  TracebackMatrix::setSelf(startRow, startCol, *editGraph.getColumn(startCol));
+  double meanContigDepth = visitColumns(startRow, startCol, endRow, endCol, TRACK_PARENTS, endDepth==-1);
+  meanContigDepth /= (endRow*endCol);
+
+  EditGraphNode endNode = editGraph.bestScoredNode;
+  if(endDepth==-1) {
+    // The best node is the end of the alignment, as in the first run of traverseGraph
+    alignment.addNodeToPath(endNode);
+  } else {
+    endNode = editGraph.getNode(endRow, endCol, endDepth);
+  }
+  if(endNode.getScore()==MINUS_INF) { return meanContigDepth; }
+
+  // Only the end node of the path keeps its score, the others keep whether they start
+  // the local alignment, which is all the tracing of the alignment reads of them
+  int row   = endNode.getRow();
+  int col   = endNode.getCol();
+  int depth = endNode.getDepth();
+  unsigned int link = traceback.getLink(row, col, depth);
+  while(!TracebackMatrix::isLocalStart(link)) {
+    if(!TracebackMatrix::hasParent(link)) {
+      // A match on the first row or column starts the alignment from the gap row or column
+      alignment.addNodeToPath(EditGraphNode(row-1, col-1, 0, 0, 0, 0));
+      break;
+    }
+    row  -= TracebackMatrix::getParentRowStep(link);
+    col  -= TracebackMatrix::getParentColStep(link);
+    depth = TracebackMatrix::getParentDepth(link);
+    if(col==startCol) { break; } // The start node is on the path of the section before
+    link = traceback.getLink(row, col, depth);
+    ColaScore score = TracebackMatrix::isLocalStart(link)? 0 : endNode.getScore();
+    alignment.addNodeToPath(EditGraphNode(row, col, depth, score, 0, 0));
+  }
+  return meanContigDepth;
+}
+
+bool NSaligner::isTraced(int startRow, int startCol, int endRow, int endCol) const {
+  // The rows of a wavefront traversal are split between the threads, the section is checkpointed
+  if(params.getTracebackMemory()<=0 || getNumWavefrontBlocks(startRow, startCol, endRow, endCol)>1) { return false; }
+  // Sections the anti-diagonal kernel scores are faster checkpointed than traced node by node.
+  // X-drop is left out as the first run of the recursion is visited node by node with it.
+  if(!editGraph.isBanded() && params.getXDrop()<0 && AntidiagNS::isSupported()) {
+    AntidiagTraversal trav = getAntidiagTraversal(startRow, startCol, endRow, endCol, (startCol+endCol)/2, false, false);
+    if(AntidiagNS(params, contigScores).isApplicable(trav)) { return false; }
+  }
+  double cellBytes = TracebackMatrix::getCellBytes(editGraph.getColumn(startCol)->getNumDepths());
+  return getNumSectionCells(startRow, startCol, endRow, endCol)*cellBytes <= params.getTracebackMemory()*1048576.0;
+}
+
+double NSaligner::getNumSectionCells(int startRow, int startCol, int endRow, int endCol) const {
+  double numRows = endRow-startRow+1;
+  if(editGraph.isBanded()) { numRows = min(numRows, 2.0*editGraph.bandWidth+1); }
+  return numRows * (endCol-startCol);
+}
+
+NSaligner* NSaligner::getRecursionWorker(int level) {
+  while((int)recursionWorkers.size()<=level) {
+    NSaligner* worker = clone();
+    worker->alignment = AlignmentCola(getTargetSeq(), getQuerySeq(), params);
+    recursionWorkers.push_back(worker);
+  }
+  return recursionWorkers[level];
+}
+
+double NSaligner::visitColumns(int startRow, int startCol, int endRow, int endCol,
+      int currCheckpointColIndex, bool findBestNode) {
+  double numNodes = 0;
+  if(visitColumnsAntidiag(startRow, startCol, endRow, endCol, currCheckpointColIndex, findBestNode, false, numNodes)) {
+    return numNodes;
+  }
+  return visitColumnsOf<NSaligner>(startRow, startCol, endRow, endCol, currCheckpointColIndex, findBestNode);
+}
+
+bool NSaligner::visitColumnsAntidiag(int startRow, int startCol, int endRow, int endCol,
+      int currCheckpointColIndex, bool findBestNode, bool affineGaps, double& numNodes) {
+  // The kernel keeps full anti-diagonals and no parents
+  if(editGraph.isBanded() || isXDropped(findBestNode) || currCheckpointColIndex==TRACK_PARENTS ||
+     !AntidiagNS::isSupported()) {
+    return false;
+  }
+  AntidiagTraversal trav = getAntidiagTraversal(startRow, startCol, endRow, endCol, currCheckpointColIndex,
+                                                findBestNode, affineGaps);
+  AntidiagNS kernel(params, contigScores);
+  if(!kernel.traverse(getTargetSeq(), getQuerySeq(), trav)) { return false; }
+
+  // The score-only pass only needs the best node, which keeps its origin
+  if(!trav.trackOrigin) {
+    // Only the checkpoint and end columns are needed by the recursion
+    editGraph.checkpointCol.setDiagonal(currCheckpointColIndex);
+    trav.checkpointCells.copyTo(startRow, editGraph.checkpointCol);
+    editGraph.initCol(endCol, startRow, endRow);
+    trav.endCells.copyTo(startRow, *editGraph.getColumn(endCol));
+  }
+  if(findBestNode) { editGraph.updateBest(trav.bestNode); }
+  numNodes = trav.numNodes;
+  return true;
+}
+
+AntidiagTraversal NSaligner::getAntidiagTraversal(int startRow, int startCol, int endRow, int endCol,
+      int currCheckpointColIndex, bool findBestNode, bool affineGaps) const {
+  AntidiagTraversal trav(startRow, startCol, endRow, endCol, currCheckpointColIndex, findBestNode,
+                         editGraph.getColumn(startCol), affineGaps);
+  trav.targetLen      = editGraph.targetLen;
+  trav.queryLen       = editGraph.queryLen;
+  trav.maxContigDepth = editGraph.maxContigDepth;
+  return trav;
+}
+
+template<bool ORIGIN>
 void NSaligner::visitNode(EditGraphNode* currNode, int currCheckpointColIndex) {
   if (currNode->getDepth() == 0) {
-    visitNodeContigZero(currNode, currCheckpointColIndex);
+    visitNodeContigZero<ORIGIN>(currNode, currCheckpointColIndex);
   } else {
-    visitNodeContigNoneZero(currNode, currCheckpointColIndex);
+    visitNodeContigNoneZero<ORIGIN>(currNode, currCheckpointColIndex);
   }
 }
 
+template<bool ORIGIN>
 void NSaligner::visitNodeContigZero(EditGraphNode* currNode, int  currCheckpointColIndex) {
   // (Step 1) Find the score from all three possible neighbours (top,left,top-left)  
   int i = currNode->getRow();
   int j = currNode->getCol();
   int k = currNode->getDepth(); // Should be zero here
-  double score1, score2, score3 = MINUS_INF;
+  ColaScore score1, score2, score3 = MINUS_INF;
   // Moving from the top or left neighbour, there is an indel, hence apply gap penalty
-  score1 = editGraph.getBestScoreAtRowCol(i, j-1) + params.getGapOpenP();
-  score2 = editGraph.getBestScoreAtRowCol(i-1, j) + params.getGapOpenP();  
+  score1 = addScore(editGraph.getBestScoreAtRowCol(i, j-1), params.getGapOpenP());
+  score2 = addScore(editGraph.getBestScoreAtRowCol(i-1, j), params.getGapOpenP());
 
   // Moving from the diagonal neighbour
-  score3 = editGraph.getBestScoreAtRowCol(i-1, j-1) + params.getMismatchP();  
+  score3 = addScore(editGraph.getBestScoreAtRowCol(i-1, j-1), params.getMismatchP());
     
   // (Step 2) Find the maximum score and set the checkpoint ancestor coordinates
   if (( score3 >= score2 ) && ( score3 >= score1)) {
      currNode->setScore(score3);
-    currNode->setCPACords(editGraph.getBestNodeAtRowCol(i-1, j-1),
+    currNode->setAncestorCords<ORIGIN>(editGraph.getBestNodeAtRowCol(i-1, j-1),
       currCheckpointColIndex);
   } else if ( score2 > score1 ) {
     currNode->setScore(score2);
-    currNode->setCPACords(editGraph.getBestNodeAtRowCol(i-1, j),
+    currNode->setAncestorCords<ORIGIN>(editGraph.getBestNodeAtRowCol(i-1, j),
       currCheckpointColIndex);
   } else {
     currNode->setScore(score1);
-    currNode->setCPACords(editGraph.getBestNodeAtRowCol(i, j-1),
+    currNode->setAncestorCords<ORIGIN>(editGraph.getBestNodeAtRowCol(i, j-1),
       currCheckpointColIndex);
   }
 } 
 
+template<bool ORIGIN>
 void NSaligner::visitNodeContigNoneZero(EditGraphNode* currNode, int  currCheckpointColIndex) {
   int k = currNode->getDepth();
   int i = currNode->getRow();
@@ -177,15 +330,12 @@ void NSaligner::visitNodeContigNoneZero(EditGraphNode* currNode, int  currCheckp
   // In case there is no match:
   currNode->setScore(MINUS_INF);
   // Moving from the diagonal neighbour only if there's a match.
-  if( getTargetSeq()[j] == getQuerySeq()[i] ) {
-    double s = editGraph.getNode(i-1,j-1,k-1)->getScore();
+  if( alignment.getTargetSeq()[j] == alignment.getQuerySeq()[i] ) {
+    ColaScore s = editGraph.getScore(i-1,j-1,k-1);
     if(i*j==0 && k==1 && s==MINUS_INF) { s = 0; } // special case for first row/column
     if (s != MINUS_INF) { 
-      //Scoring should become modular TODO 
-//      currNode->setScore(s - exp(((k-1)-3)/1) + exp((k-3)/1));  
-//      currNode->setScore(s - pow(1.5, ((k-1)-3)/1) + pow(1.5,(k-3)/1));  
-      currNode->setScore(s - pow(((k-1)-0)/1.0, 3) + pow((k-0)/1.0, 3));  
-      currNode->setCPACords(editGraph.getNode(i-1, j-1, k-1),
+      currNode->setScore(addScore(s, contigScores.getIncrement(k)));
+      currNode->setAncestorCords<ORIGIN>(editGraph.getNode(i-1, j-1, k-1),
         currCheckpointColIndex);
     } 
   }
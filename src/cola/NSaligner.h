@@ -8,6 +8,14 @@
 #include "AlignmentCola.h"
 #include "IAligner.h"
 #include "AlignerParams.h"
+#include "Wavefront.h"
+#include "TracebackMatrix.h"
+#include "AntidiagNS.h"
+
+// The cache the two columns of a tile are sized to fit in, see NSaligner::traverseTiles
+#define TILE_CACHE_BYTES (1<<19)
+// The number of columns of a tile
+#define TILE_COLS 256
 
 //=====================================================================
 /**
@@ -29,9 +37,21 @@ public:
    */
   NSaligner(const DNAVector& tSeq, const DNAVector& qSeq, 
             const AlignerParams& p = AlignerParams(NS), int maxDepth=10000)
-    :editGraph(tSeq.size(), qSeq.size(), maxDepth, p.getBandWidth()), alignment(tSeq, qSeq, p), params(p) {}
+    :editGraph(tSeq.size(), qSeq.size(), maxDepth, p.getBandWidth(), p.isAdaptiveBand()), alignment(tSeq, qSeq, p), params(p),
+     contigScores(p.getContigScoring(), min(maxDepth, min(tSeq.isize(), qSeq.isize()))),
+     threadBudget(p.getNumThreads()), wavefrontWorkers(), recursionWorkers(), numForks(0),
+     deepCandidates(), traceback() {}
+
+  /** The copy has the graph and parameters, but none of the workers */
+  NSaligner(const NSaligner& other)
+    :IAligner(other), editGraph(other.editGraph), alignment(other.alignment), params(other.params),
+     contigScores(other.contigScores), threadBudget(other.threadBudget), wavefrontWorkers(), recursionWorkers(), numForks(0),
+     deepCandidates(), traceback() {}
 
-  ~NSaligner() {}
+  ~NSaligner() {
+    for(int i=0; i<(int)wavefrontWorkers.size(); i++) { delete wavefrontWorkers[i]; }
+    for(int i=0; i<(int)recursionWorkers.size(); i++) { delete recursionWorkers[i]; }
+  }
 
   /** 
    * main function to call for performing the alignment.
@@ -40,9 +60,22 @@ public:
   virtual const AlignmentCola& align();
   virtual const AlignmentCola& align(int targetStartIdx, int queryStartIdx, int targetStopIdx, int queryStopIdx);
 
+  /**
+   * Score-only pass over the graph: a single traversal keeping the start of the
+   * local alignment of every node instead of its checkpoint ancestor.
+   * @return Returns the best score and the cells the alignment starts and ends on
+   */
+  virtual AlignmentScore score(int targetStartIdx, int queryStartIdx, int targetStopIdx, int queryStopIdx);
+
+  /** Set the aligner up for other sequences, keeping its buffers (see IAligner::reset) */
+  virtual void reset(const DNAVector& tSeq, const DNAVector& qSeq, const AlignerParams& p);
+
   /** Returns the alignment object which contains the alignment strings and info **/
   virtual const AlignmentCola& getAlignment() { return alignment; }
 
+  /** Moves the alignment out of the aligner (see IAligner::takeAlignment) */
+  virtual AlignmentCola takeAlignment() { return alignment.release(); }
+
   /** Returns the target sequence used for the alignment */
   virtual const DNAVector& getTargetSeq() { return alignment.getTargetSeq(); } 
 
@@ -54,24 +87,231 @@ protected:
    * Visit all the nodes in the given subsection of the editgraph in turn
    * and assign their relevant score and find the middle node on 
    * the optimal path checkpoint column and pass it to next recursion.
+   * If both halves of the recursion are large and more than one thread
+   * is available the second half is visited by the recursion worker
+   * on another thread, its path nodes are then added to this alignment.
+   * Sections within the traceback memory of the params are traced instead (see traceGraph).
    * @param[in] starting point (row and column), ending point (start and end)
    * @return Returns the mean contiguity depth traversed - Note that this would include affine depths
    */
   double traverseGraph(int startRow, int startCol, int endRow,
        int endCol, int endDepth, const EditGraphDepth& checkpointCell);
 
+  /**
+   * Visit a section of the graph once keeping the parent of every node (see TracebackMatrix)
+   * and add the nodes of the optimal path between its start and end nodes to the path,
+   * or from the best node if the end is not known.
+   * @param[in] starting point (row and column), ending point (start and end)
+   * @param[in] endDepth: The depth of the end node, -1 in the first run
+   * @return Returns the mean contiguity depth traversed (see traverseGraph)
+   */
+  double traceGraph(int startRow, int startCol, int endRow, int endCol, int endDepth);
+
+  /**
+   * Whether the parents of the nodes of a section fit in the traceback memory of the params,
+   * unless the anti-diagonal kernel scores it
+   */
+  virtual bool isTraced(int startRow, int startCol, int endRow, int endCol) const;
+
+  /** The number of cells of a section visited after its start column, at most the band in banded mode */
+  double getNumSectionCells(int startRow, int startCol, int endRow, int endCol) const;
+
+  /** Returns a copy of this aligner of the same type (see the copy constructor) */
+  virtual NSaligner* clone() const { return new NSaligner(*this); }
+
+  /**
+   * The copy of this aligner visiting the second half of the recursion, created on first use.
+   * The first half may be split again while the worker is busy, so there is one per nested split.
+   * @param[in] The number of splits this aligner is visiting the first half of
+   */
+  NSaligner* getRecursionWorker(int level);
+
+  /**
+   * Visit the nodes of the columns after startCol up to endCol, between the
+   * start and end rows, setting their scores and checkpoint ancestors.
+   * The middle column is checkpointed and the best scored node updated.
+   * @param[in] starting point (row and column), ending point (start and end)
+   * @param[in] Index of column that should be checkpointed in current iteration
+   * @param[in] Whether the best scored node is needed (i.e. the end node is not known)
+   * @return Returns the sum of the contiguity depths traversed over all cells
+   */
+  virtual double visitColumns(int startRow, int startCol, int endRow, int endCol,
+       int currCheckpointColIndex, bool findBestNode);
+
+  /**
+   * Score the section with the anti-diagonal kernel (see AntidiagNS) and set the checkpoint
+   * and end columns and the best node from it, as the node by node traversal would.
+   * Banded, X-dropped and traced sections are left to the latter, as are those the kernel
+   * does not apply to or gives up on, in which case the edit graph is left as it was.
+   * @param[in] affineGaps: Whether the first two depths are the affine gaps (NSGA)
+   * @param[out] numNodes: The number of nodes visited (see visitColumns)
+   * @return Returns true if the kernel scored the section
+   */
+  bool visitColumnsAntidiag(int startRow, int startCol, int endRow, int endCol,
+       int currCheckpointColIndex, bool findBestNode, bool affineGaps, double& numNodes);
+
+  /** The section of the anti-diagonal kernel for the given one of the graph (see AntidiagTraversal) */
+  AntidiagTraversal getAntidiagTraversal(int startRow, int startCol, int endRow, int endCol,
+       int currCheckpointColIndex, bool findBestNode, bool affineGaps) const;
+
+  /**
+   * The node by node traversal of visitColumns specialized at compile time on
+   * the aligner scoring the nodes and on banded mode, so that the nodes are
+   * visited with direct calls that can be inlined rather than virtual ones.
+   * Each aligner instantiates it in its own translation unit.
+   * @param ALIGNER: The aligner class whose visitNode scores the nodes
+   * @param BANDED: Whether the rows out of the band are skipped
+   * @param ORIGIN: Whether the nodes keep their origin (score-only pass, see TRACK_ORIGIN)
+   */
+  template<class ALIGNER, bool BANDED, bool ORIGIN>
+  double traverseColumns(int startRow, int startCol, int endRow, int endCol,
+       int currCheckpointColIndex, bool findBestNode);
+
+  /**
+   * X-drop traverseColumns for the pass finding the best node: a cell whose best node scores more
+   * than the X-drop of the params below the best node found so far is unreachable, i.e. dropped.
+   * Each column is visited from the first live row of the previous column, and past its last
+   * live row only while the cells are reached down the column. The traversal stops at the
+   * first column with no live cell, the best node of the section can not be beyond it.
+   */
+  template<class ALIGNER, bool BANDED, bool ORIGIN>
+  double traverseColumnsXDrop(int startRow, int startCol, int endRow, int endCol,
+       int currCheckpointColIndex);
+
+  /** Whether the cells are dropped in the pass (see traverseColumnsXDrop) */
+  bool isXDropped(bool findBestNode) const { return findBestNode && params.getXDrop()>=0; }
+
+  /** The score the best node of a live cell is at least, MINUS_INF until a node is reached */
+  ColaScore getXDropScore() const {
+    ColaScore bestScore = editGraph.bestScoredNode.getScore();
+    return (bestScore==MINUS_INF)? MINUS_INF : bestScore-params.getXDrop();
+  }
+
+  /**
+   * Visit the nodes of a column between the given rows (see traverseColumns)
+   * @return Returns the sum of the contiguity depths traversed over the cells
+   */
+  template<class ALIGNER, bool ORIGIN>
+  double visitColumnCells(int col, int start, int end, int currCheckpointColIndex, bool findBestNode);
+
+  /**
+   * Visit the nodes of a cell above the base depths (see visitColumnCells)
+   * @param[in,out] bestScore: The score the best node of the cell is stored with
+   * @return Returns the number of nodes kept
+   */
+  template<class ALIGNER, bool ORIGIN>
+  double visitDeepNodes(int row, int col, int currCheckpointColIndex, bool findBestNode, ColaScore& bestScore);
+
+  /**
+   * Visit a node of a cell and keep it as the best of the cell if it is (see visitColumnCells)
+   * @param[in,out] bestScore: The score the best node of the cell is stored with
+   * @return Returns false for a node above the base depths that is not on a run of matches
+   */
+  template<class ALIGNER, bool ORIGIN>
+  bool visitCellNode(EditGraphNode& currNode, int row, int col, int depth,
+       int currCheckpointColIndex, bool findBestNode, ColaScore& bestScore);
+
+  /**
+   * Multi-threaded traverseColumns for large unbanded sections: the rows are split into blocks
+   * that are each visited by a worker aligner on its own thread (see WavefrontState).
+   * The cells passed between the blocks keep their checkpoint ancestors, so once the
+   * checkpoint and end columns and the best node of the workers are gathered into
+   * this edit graph the recursion goes on as if the section was visited here.
+   * @param[in] numBlocks: The number of blocks/threads
+   */
+  template<class ALIGNER, bool ORIGIN>
+  double traverseWavefront(int startRow, int startCol, int endRow, int endCol,
+       int currCheckpointColIndex, bool findBestNode, int numBlocks);
+
+  /**
+   * Visit a block of rows of the wavefront traversal in the edit graph of this (worker) aligner
+   * @param[in] state: The blocks and the cells passed between them
+   * @param[in] block: The index of the block to visit
+   * @param[in] source: The edit graph holding the start column of the section
+   * @return Returns the sum of the contiguity depths traversed over the cells of the block
+   */
+  template<class ALIGNER, bool ORIGIN>
+  double visitBlock(WavefrontState& state, int block, const EditGraph& source, int startCol, int endCol,
+       int currCheckpointColIndex, bool findBestNode);
+
+  /**
+   * Single-threaded traverseColumns for large unbanded sections, whose columns do not fit in
+   * the cache. The graph is visited in tiles of TILE_COLS columns by tileRows rows: the rows
+   * are split into blocks, and each span of columns is visited block by block, top to bottom,
+   * before the next span. The blocks share the columns of the graph. The last cell of a block
+   * at every column of the span is passed down to the block below, as is the one at the column
+   * before the span, which the tiles of the block above have overwritten since.
+   * The best node is kept per block and merged as if the nodes were visited column by column
+   * (see EditGraph::mergeBest), so the outcome is that of traverseColumns.
+   * @param[in] tileRows: The number of rows of a tile (see getNumTileRows)
+   */
+  template<class ALIGNER, bool ORIGIN>
+  double traverseTiles(int startRow, int startCol, int endRow, int endCol,
+       int currCheckpointColIndex, bool findBestNode, int tileRows);
+
+  /** The number of rows of a tile whose two columns fit in the cache, 0 if the section is not worth tiling */
+  int getNumTileRows(int startRow, int startCol, int endRow, int endCol) const {
+    int tileRows = TILE_CACHE_BYTES/(2*EditGraphColumn::getCellBytes(editGraph.getColumn(startCol)->getNumDepths()));
+    if(endCol-startCol<2*TILE_COLS || endRow-startRow+1<2*tileRows) { return 0; }
+    return tileRows;
+  }
+
+  /** The number of blocks a section is split into for the wavefront traversal, 1 if not worth it */
+  int getNumWavefrontBlocks(int startRow, int startCol, int endRow, int endCol) const {
+    if(threadBudget<2 || endCol-startCol<WAVEFRONT_MIN_COLS) { return 1; }
+    return max(1, min(threadBudget, (endRow-startRow+1)/WAVEFRONT_MIN_ROWS));
+  }
+
+  /**
+   * Runs the traverseColumns specialization for the banded mode of the edit graph and the pass,
+   * or the wavefront traversal if the section is large enough to be split between threads
+   */
+  template<class ALIGNER>
+  double visitColumnsOf(int startRow, int startCol, int endRow, int endCol,
+       int currCheckpointColIndex, bool findBestNode) {
+    bool origin = (currCheckpointColIndex == TRACK_ORIGIN);
+    if(editGraph.isBanded()) {
+      return origin? traverseColumns<ALIGNER, true, true>(startRow, startCol, endRow, endCol, currCheckpointColIndex, findBestNode)
+                   : traverseColumns<ALIGNER, true, false>(startRow, startCol, endRow, endCol, currCheckpointColIndex, findBestNode);
+    }
+    // The live rows of an X-drop column depend on the previous one, so it is not split into blocks
+    int numBlocks = getNumWavefrontBlocks(startRow, startCol, endRow, endCol);
+    if(numBlocks>1 && !isXDropped(findBestNode)) {
+      return origin? traverseWavefront<ALIGNER, true>(startRow, startCol, endRow, endCol, currCheckpointColIndex, findBestNode, numBlocks)
+                   : traverseWavefront<ALIGNER, false>(startRow, startCol, endRow, endCol, currCheckpointColIndex, findBestNode, numBlocks);
+    }
+    // The parents of a traced section are kept column by column, so it is not tiled either
+    int tileRows = getNumTileRows(startRow, startCol, endRow, endCol);
+    if(tileRows>0 && !isXDropped(findBestNode) && currCheckpointColIndex!=TRACK_PARENTS) {
+      return origin? traverseTiles<ALIGNER, true>(startRow, startCol, endRow, endCol, currCheckpointColIndex, findBestNode, tileRows)
+                   : traverseTiles<ALIGNER, false>(startRow, startCol, endRow, endCol, currCheckpointColIndex, findBestNode, tileRows);
+    }
+    return origin? traverseColumns<ALIGNER, false, true>(startRow, startCol, endRow, endCol, currCheckpointColIndex, findBestNode)
+                 : traverseColumns<ALIGNER, false, false>(startRow, startCol, endRow, endCol, currCheckpointColIndex, findBestNode);
+  }
+
   /** 
    * Takes a node and decide how it should be visited to set its  score and origin
+   * N.B. This is not virtual, derived aligners hide it with their own which is
+   * called through traverseColumns.
    * @param[in]  The node to be visited 
    * @param[in] Index of column that should be checkpointed in current iteration
    */
-  virtual void visitNode(EditGraphNode* currNode, int currCheckpointColIndex); 
+  template<bool ORIGIN>
+  void visitNode(EditGraphNode* currNode, int currCheckpointColIndex); 
+
+  /** The minimum score added by a match, used for bounding the alignment in the score-only pass */
+  virtual int getMinMatchScore() const { return contigScores.getMinIncrement(); }
+
+  /** The number of contiguous matches scored by a node at the given depth */
+  static int getMatchDepth(int depth) { return depth; }
 
   /** 
    * Takes a node with contiguity depth of zero and sets the node scores
    * @param[in]  The node to be visited 
    * @param[in] Index of column that should be checkpointed in current iteration
    */
+  template<bool ORIGIN>
   void visitNodeContigZero(EditGraphNode* currNode, int currCheckpointColIndex); 
 
   /** 
@@ -79,15 +319,310 @@ protected:
    * @param[in]  The node to be visited 
    * @param[in] Index of column that should be checkpointed in current iteration
    */
+  template<bool ORIGIN>
   void visitNodeContigNoneZero(EditGraphNode* currNode, int currCheckpointColIndex);
 
 
   EditGraph     editGraph; /// The edit graph used for calculating the path scores
   AlignmentCola alignment; /// Object containing the backtraced alignment
   AlignerParams params;    /// The generic object which includes the relevant penalties
+  ContigScoreTable contigScores; /// The score added by each contiguous match, by depth
+  int threadBudget;        /// The number of threads this aligner may use, split with the recursion worker
+  vector<NSaligner*> wavefrontWorkers; /// Copies of this aligner visiting the blocks of the wavefront traversal
+  vector<NSaligner*> recursionWorkers; /// Copies of this aligner visiting the second halves of the recursion
+  int numForks;                        /// The number of splits of the recursion this aligner is in the first half of
+  vector<EditGraphNode> deepCandidates;/// The nodes of the latest cell above the base depths, before pruning
+  TracebackMatrix traceback;           /// The parents of the nodes of the latest section traced
 };
 
+//=====================================================================
+template<class ALIGNER, bool BANDED, bool ORIGIN>
+double NSaligner::traverseColumns(int startRow, int startCol, int endRow, int endCol,
+      int currCheckpointColIndex, bool findBestNode) {
+  if(isXDropped(findBestNode)) {
+    return traverseColumnsXDrop<ALIGNER, BANDED, ORIGIN>(startRow, startCol, endRow, endCol, currCheckpointColIndex);
+  }
+  double meanContigDepth = 0;
+  // Start from the column after the startCol where the cell from previous
+  // calculations was set for restarting calculations
+  for ( int col=startCol+1; col<=endCol; col++ ) {
+    //Reset column
+    editGraph.initCol(col, startRow, endRow); 
+    //banded alignment - skip out-of-band cells
+    int center = editGraph.getBandCenter(col);
+    int start  = BANDED? max(startRow, center-editGraph.bandWidth) : startRow;
+    int end    = BANDED? min(endRow, center+editGraph.bandWidth)   : endRow;
+    meanContigDepth += visitColumnCells<ALIGNER, ORIGIN>(col, start, end, currCheckpointColIndex, findBestNode);
+    //Checkpoint middle column - keep for retrieving the checkpoint cell
+    if(col == currCheckpointColIndex){ 
+      editGraph.checkPoint(col, start, end);
+    }
+    if(BANDED && findBestNode && editGraph.isAdaptiveBand()) { editGraph.centerNextBand(col, start, end); }
+  }
+  return meanContigDepth;
+}
+
+template<class ALIGNER, bool BANDED, bool ORIGIN>
+double NSaligner::traverseColumnsXDrop(int startRow, int startCol, int endRow, int endCol,
+      int currCheckpointColIndex) {
+  double meanContigDepth = 0;
+  int liveStart   = startRow; // The first live row of the previous column
+  int liveEnd     = endRow;   // The last live row of the previous column
+  int prevInitEnd = endRow;   // The last row of the previous column that was reset
+  for ( int col=startCol+1; col<=endCol; col++ ) {
+    int center = editGraph.getBandCenter(col);
+    int start  = max(BANDED? max(startRow, center-editGraph.bandWidth) : startRow, liveStart);
+    int end    = BANDED? min(endRow, center+editGraph.bandWidth) : endRow;
+    if(start>end) { break; }
+    // Only the rows up to the one after the live rows are reset, the others are reset when reached
+    int initEnd = min(end, liveEnd+1);
+    editGraph.initCol(col, start, initEnd);
+    EditGraphColumn* column     = editGraph.getColumn(col);
+    EditGraphColumn* prevColumn = editGraph.getColumn(col-1);
+    int firstLive = -1, lastLive = -1;
+    int row;
+    for ( row=start; row<=end; row++ ) {
+      if(row>initEnd) {
+        // Past the live rows of the previous column a cell is only reached from the one above
+        if(lastLive<row-1) { break; }
+        column->initCell(row);
+        initEnd = row;
+        if(row>prevInitEnd) {
+          prevColumn->initCell(row);
+          prevInitEnd = row;
+        }
+      }
+      // The cells are dropped as they are visited, so no live cell is reached through a dropped one
+      meanContigDepth += visitColumnCells<ALIGNER, ORIGIN>(col, row, row, currCheckpointColIndex, true);
+      if(column->getBestScore(row)<getXDropScore()) {
+        column->initCell(row);
+      } else {
+        if(firstLive<0) { firstLive = row; }
+        lastLive = row;
+      }
+    }
+    // The next column also reads the row after the visited ones
+    if(row<=endRow && row>initEnd) {
+      column->initCell(row);
+      initEnd = row;
+    }
+    //Checkpoint middle column - keep for retrieving the checkpoint cell
+    if(col == currCheckpointColIndex){ 
+      editGraph.checkPoint(col, start, row-1);
+    }
+    if(BANDED && editGraph.isAdaptiveBand()) { editGraph.centerNextBand(col, start, row-1); }
+    if(firstLive<0) { break; } // The whole column is dropped
+    liveStart   = firstLive;
+    liveEnd     = lastLive;
+    prevInitEnd = initEnd;
+  }
+  return meanContigDepth;
+}
+
+template<class ALIGNER, bool ORIGIN>
+double NSaligner::visitColumnCells(int col, int start, int end, int currCheckpointColIndex, bool findBestNode) {
+  double meanContigDepth = 0;
+  EditGraphNode currNode;
+  int baseDepth = min(editGraph.maxContigDepth, EDITGRAPH_BASE_DEPTHS-1);
+  for ( int row=start; row<=end; row++ ) {
+    // The cell is visited from its reset state, the deeper nodes are not stored before it is done
+    ColaScore bestScore = MINUS_INF;
+    for ( int depth=0; depth<=baseDepth; depth++) {
+      visitCellNode<ALIGNER, ORIGIN>(currNode, row, col, depth, currCheckpointColIndex, findBestNode, bestScore);
+      editGraph.setNode(currNode);
+      meanContigDepth++;
+    }
+    if(baseDepth<editGraph.maxContigDepth) {
+      meanContigDepth += visitDeepNodes<ALIGNER, ORIGIN>(row, col, currCheckpointColIndex, findBestNode, bestScore);
+    }
+    if(currCheckpointColIndex==TRACK_PARENTS) {
+      traceback.addCell(row, col, *editGraph.getColumn(col));
+    }
+  }
+  return meanContigDepth;
+}
+
+template<class ALIGNER, bool ORIGIN>
+double NSaligner::visitDeepNodes(int row, int col, int currCheckpointColIndex, bool findBestNode, ColaScore& bestScore) {
+  EditGraphNode currNode;
+  int maxDepth  = editGraph.maxContigDepth;
+  int baseDepth = min(maxDepth, EDITGRAPH_BASE_DEPTHS-1);
+  const EditGraphColumn* prevColumn = editGraph.getColumn(col-1);
+  // A node above the base depths extends the diagonal neighbour one depth lower, so the
+  // depths worth visiting are one past each node the diagonal neighbour has from its top
+  // base depth on. Runs of matches bound these, no depth is probed. The special cases of
+  // the first row and column are all at the base depths.
+  deepCandidates.clear();
+  if(prevColumn->getScore(row-1, baseDepth)!=MINUS_INF &&
+     visitCellNode<ALIGNER, ORIGIN>(currNode, row, col, baseDepth+1, currCheckpointColIndex, findBestNode, bestScore)) {
+    deepCandidates.push_back(currNode);
+  }
+  int numDiagNodes = prevColumn->getNumDeepNodes(row-1);
+  for ( int i=0; i<numDiagNodes && prevColumn->getDeepNode(row-1, i).depth<maxDepth; i++) {
+    int depth = prevColumn->getDeepNode(row-1, i).depth+1;
+    if(visitCellNode<ALIGNER, ORIGIN>(currNode, row, col, depth, currCheckpointColIndex, findBestNode, bestScore)) {
+      deepCandidates.push_back(currNode);
+    }
+  }
+  if(deepCandidates.empty()) { return 0; }
+  // (Step 4d) Drop the nodes a deeper one scores higher than: the rest of the run adds at least
+  // as much to the deeper one (see ContigScoreTable::getMonotoneDepth), so it stays ahead and
+  // the dropped node can not be the best of any cell. This needs the deeper node not to reach
+  // the maximum depth before the end of the graph, where its run would be cut short.
+  int topDepth  = deepCandidates.back().getDepth();
+  bool canPrune = topDepth + min(editGraph.queryLen-1-row, editGraph.targetLen-1-col) <= maxDepth;
+  ColaScore deeperScore = MINUS_INF;
+  for(int i=deepCandidates.size()-1; canPrune && i>=0; i--) {
+    ColaScore score = deepCandidates[i].getScore();
+    if(score<deeperScore && ALIGNER::getMatchDepth(deepCandidates[i].getDepth())+1>=contigScores.getMonotoneDepth()) {
+      deepCandidates[i].setScore(MINUS_INF); // Not kept
+    }
+    deeperScore = max(deeperScore, score);
+  }
+  for(int i=0; i<(int)deepCandidates.size(); i++) {
+    editGraph.setNode(deepCandidates[i]);
+  }
+  return deepCandidates.size();
+}
+
+template<class ALIGNER, bool ORIGIN>
+inline bool NSaligner::visitCellNode(EditGraphNode& currNode, int row, int col, int depth,
+      int currCheckpointColIndex, bool findBestNode, ColaScore& bestScore) {
+  currNode.setCoords(row, col, depth); 
+  currNode.setScore(MINUS_INF); // Nodes are visited from their reset state
+  static_cast<ALIGNER*>(this)->ALIGNER::template visitNode<ORIGIN>(&currNode, currCheckpointColIndex);
+  if( currNode.getScore() == MINUS_INF && depth>=EDITGRAPH_BASE_DEPTHS ) { return false; } // Not on a run of matches
+  // (Step 4a) Update the current best node accordingly
+  if(findBestNode) { editGraph.updateBest(currNode); }
+  // (Step 4b) Set the best node for the current cell position
+  bool isBest = (currNode.getScore() > bestScore);
+  if(isBest) { 
+    editGraph.setBestNodeAtRowCol(row, col, currNode.getDepth()); 
+  }
+  // (Step 4c) For local alignment, if score is negative, set to zero 
+  if(currNode.getScore()!=MINUS_INF && currNode.getScore()<0) {
+    currNode.setScore(0);
+  }
+  if(isBest) { bestScore = currNode.getScore(); }
+  return true;
+}
+
+//=====================================================================
+template<class ALIGNER, bool ORIGIN>
+double NSaligner::traverseTiles(int startRow, int startCol, int endRow, int endCol,
+      int currCheckpointColIndex, bool findBestNode, int tileRows) {
+  int numBlocks = (endRow-startRow+tileRows)/tileRows;
+  EditGraphDepth emptyCell(editGraph.maxContigDepth);
+  // The last cell of each block at the column before the current span, starting from the start column
+  vector<EditGraphDepth> spanBoundaries(numBlocks, emptyCell);
+  for(int b=0; b+1<numBlocks; b++) {
+    editGraph.getColumn(startCol)->getCell(startRow + (b+1)*tileRows - 1, startCol, spanBoundaries[b]);
+  }
+  // The last cells of the block above over the span and those of the current block, from the column before it
+  vector<EditGraphDepth> aboveCells(TILE_COLS+1, emptyCell);
+  vector<EditGraphDepth> blockCells(TILE_COLS+1, emptyCell);
+  vector<EditGraphNode> blockBests(numBlocks);
+  for(int b=0; b<numBlocks; b++) { blockBests[b].setScore(MINUS_INF); }
+  double meanContigDepth = 0;
+  for(int spanStart=startCol+1; spanStart<=endCol; spanStart+=TILE_COLS) {
+    int spanEnd = min(endCol, spanStart+TILE_COLS-1);
+    for(int b=0; b<numBlocks; b++) {
+      int firstRow = startRow + b*tileRows;
+      int lastRow  = min(endRow, firstRow+tileRows-1);
+      editGraph.bestScoredNode = blockBests[b];
+      if(b>0) { editGraph.getColumn(spanStart-1)->setCell(firstRow-1, aboveCells[0]); }
+      if(b+1<numBlocks) { blockCells[0] = spanBoundaries[b]; }
+      for(int col=spanStart; col<=spanEnd; col++) {
+        editGraph.initCol(col, firstRow, lastRow);
+        // The cell above the block is the last one of the block above
+        if(b>0) { editGraph.getColumn(col)->setCell(firstRow-1, aboveCells[col-spanStart+1]); }
+        meanContigDepth += visitColumnCells<ALIGNER, ORIGIN>(col, firstRow, lastRow, currCheckpointColIndex, findBestNode);
+        if(col == currCheckpointColIndex) {
+          editGraph.checkPoint(col, firstRow, lastRow);
+        }
+        if(b+1<numBlocks) { editGraph.getColumn(col)->getCell(lastRow, col, blockCells[col-spanStart+1]); }
+      }
+      if(b+1<numBlocks) { spanBoundaries[b] = blockCells[spanEnd-spanStart+1]; }
+      blockBests[b] = editGraph.bestScoredNode;
+      aboveCells.swap(blockCells);
+    }
+  }
+  editGraph.resetBest();
+  if(findBestNode) {
+    for(int b=0; b<numBlocks; b++) { editGraph.mergeBest(blockBests[b]); }
+  }
+  return meanContigDepth;
+}
+
+template<class ALIGNER, bool ORIGIN>
+double NSaligner::traverseWavefront(int startRow, int startCol, int endRow, int endCol,
+      int currCheckpointColIndex, bool findBestNode, int numBlocks) {
+  // The workers are kept for the later sections, each has its own graph as the
+  // column arenas grow while visiting
+  while((int)wavefrontWorkers.size()<numBlocks) {
+    wavefrontWorkers.push_back(clone());
+  }
+  WavefrontState state(startRow, endRow, startCol, numBlocks, editGraph.maxContigDepth);
+  vector<double> depthSums(numBlocks, 0);
+  vector<thread> threads;
+  for(int b=1; b<numBlocks; b++) {
+    threads.push_back(thread([&, b]() {
+      depthSums[b] = wavefrontWorkers[b]->visitBlock<ALIGNER, ORIGIN>(state, b, editGraph, startCol, endCol,
+                                                                     currCheckpointColIndex, findBestNode);
+    }));
+  }
+  depthSums[0] = wavefrontWorkers[0]->visitBlock<ALIGNER, ORIGIN>(state, 0, editGraph, startCol, endCol,
+                                                                 currCheckpointColIndex, findBestNode);
+  for(int t=0; t<(int)threads.size(); t++) { threads[t].join(); }
+
+  // Gather the columns needed by the recursion and the best node
+  double meanContigDepth = 0;
+  bool checkpointed = (currCheckpointColIndex>startCol && currCheckpointColIndex<=endCol);
+  if(checkpointed) { editGraph.checkpointCol.setDiagonal(currCheckpointColIndex); }
+  editGraph.initCol(endCol, startRow, endRow);
+  EditGraphColumn* endColumn = editGraph.getColumn(endCol);
+  for(int b=0; b<numBlocks; b++) {
+    const EditGraph& workerGraph = wavefrontWorkers[b]->editGraph;
+    for(int row=state.getFirstRow(b); row<=state.getLastRow(b); row++) {
+      endColumn->copyCell(row, *workerGraph.getColumn(endCol));
+      if(checkpointed) { editGraph.checkpointCol.copyCell(row, workerGraph.checkpointCol); }
+    }
+    if(findBestNode) { editGraph.mergeBest(workerGraph.bestScoredNode); }
+    meanContigDepth += depthSums[b];
+  }
+  return meanContigDepth;
+}
 
+template<class ALIGNER, bool ORIGIN>
+double NSaligner::visitBlock(WavefrontState& state, int block, const EditGraph& source, int startCol, int endCol,
+      int currCheckpointColIndex, bool findBestNode) {
+  int firstRow = state.getFirstRow(block);
+  int lastRow  = state.getLastRow(block);
+  editGraph.initCol(startCol, firstRow, lastRow);
+  for(int row=firstRow-1; row<=lastRow; row++) {
+    editGraph.getColumn(startCol)->copyCell(row, *source.getColumn(startCol));
+  }
+  editGraph.resetBest();
+  double meanContigDepth = 0;
+  for(int col=startCol+1; col<=endCol; col++) {
+    editGraph.initCol(col, firstRow, lastRow);
+    // The cell above the block is the last one of the block above
+    if(block>0) {
+      state.waitForColumn(block-1, col);
+      editGraph.getColumn(col)->setCell(firstRow-1, state.getBoundary(block-1, col));
+    }
+    meanContigDepth += visitColumnCells<ALIGNER, ORIGIN>(col, firstRow, lastRow, currCheckpointColIndex, findBestNode);
+    if(col == currCheckpointColIndex) {
+      editGraph.checkPoint(col, firstRow, lastRow);
+    }
+    if(block+1<state.getNumBlocks()) {
+      state.waitForRing(block, col);
+      editGraph.getColumn(col)->getCell(lastRow, col, state.getBoundary(block, col));
+    }
+    state.setColumnDone(block, col);
+  }
+  return meanContigDepth;
+}
 
 #endif //_NSALIGNER_H_
 
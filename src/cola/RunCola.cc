@@ -16,7 +16,15 @@ int main(int argc,char** argv)
   commandArg<bool>   selfCmd("-all","all alignments", false);
   commandArg<double> maxPCmd("-p","Maximum acceptable P-value", 1.0);
   commandArg<double> minIdentCmd("-i","Minium acceptable identity", 0.0);
+  commandArg<double> minScoreCmd("-s","Minimum score for aligning a pair in full with -all (SWGA/SW unbanded only)", 1.0);
   commandArg<int>    bandedCmd("-b", "The bandwidth for banded mode, default is for unbanded", -1);
+  commandArg<bool>   adaptiveCmd("-A", "Adaptive band, following the best scoring diagonal in banded mode", false);
+  commandArg<int>    contigScoreCmd("-c", "Contiguity scoring for NSGA/NS - Choose 0 : cubic, 1 : exponential", 0);
+  commandArg<double> contigBaseCmd("-x", "The base of exponential contiguity scoring", 1.5);
+  commandArg<int>    xDropCmd("-X", "X-drop, the score below the best one past which cells are dropped, default is for none", -1);
+  commandArg<int>    threadCmd("-T", "Number of threads for aligning a single pair (NSGA/NS/SWGA)", 1);
+  commandArg<int>    tracebackCmd("-M", "Memory in MB for tracing sections of the graph without checkpointing (NSGA/NS/SWGA), 0 for none", 64);
+  commandArg<bool>   localizeCmd("-l", "Localize, trace only the extent of the best alignment found by a score-only pass (SWGA/SW)", false);
   commandArg<string> appLogCmd("-L","Application logging file","application.log");
 
   commandLineParser P(argc,argv);
@@ -30,7 +38,15 @@ int main(int argc,char** argv)
   P.registerArg(selfCmd);
   P.registerArg(maxPCmd);
   P.registerArg(minIdentCmd);
+  P.registerArg(minScoreCmd);
   P.registerArg(bandedCmd);
+  P.registerArg(adaptiveCmd);
+  P.registerArg(contigScoreCmd);
+  P.registerArg(contigBaseCmd);
+  P.registerArg(xDropCmd);
+  P.registerArg(threadCmd);
+  P.registerArg(tracebackCmd);
+  P.registerArg(localizeCmd);
   P.registerArg(appLogCmd);
 
   P.parse();
@@ -44,7 +60,15 @@ int main(int argc,char** argv)
   bool        bAll        = P.GetBoolValueFor(selfCmd);
   double      maxP        = P.GetDoubleValueFor(maxPCmd);
   double      minIdent    = P.GetDoubleValueFor(minIdentCmd);
+  double      minScore    = P.GetDoubleValueFor(minScoreCmd);
   int         banded      = P.GetIntValueFor(bandedCmd);
+  bool        adaptive    = P.GetBoolValueFor(adaptiveCmd);
+  int         contigScore = P.GetIntValueFor(contigScoreCmd);
+  double      contigBase  = P.GetDoubleValueFor(contigBaseCmd);
+  int         xDrop       = P.GetIntValueFor(xDropCmd);
+  int         numThreads  = P.GetIntValueFor(threadCmd);
+  int         tracebackMB = P.GetIntValueFor(tracebackCmd);
+  bool        localize    = P.GetBoolValueFor(localizeCmd);
   string      appLogFile  = P.GetStringValueFor(appLogCmd);
 
   vecDNAVector query, target;
@@ -59,18 +83,45 @@ int main(int argc,char** argv)
   Output2FILE::Stream()     = pFile;
   FILELog::ReportingLevel() = logINFO; 
   
+  AlignerParams params(banded, aType);
+  if(gapOpenPen && mismatchPen && gapExtPen) {
+    params = AlignerParams(banded, aType, -gapOpenPen, -mismatchPen, -gapExtPen);
+  } // If params are not given, use default mode
+  params.setContigScoring(ContigScoring(contigScore==1? EXPONENTIAL_CS : CUBIC_CS, contigBase));
+  params.setAdaptiveBand(adaptive);
+  params.setXDrop(xDrop);
+  params.setNumThreads(numThreads);
+  params.setTracebackMemory(tracebackMB);
+  params.setLocalized(localize);
+
+  // With -all, each query is aligned against all the targets as a batch
+  vector< vector<ColaBatchResult> > batchResults;
+  if (bAll) {
+    batchResults.resize(query.isize());
+    for (j=0; j<query.isize(); j++) {
+      Cola cola1 = Cola();
+      cola1.createAlignments(target, query[j], params, maxP, minIdent, minScore, batchResults[j]);
+    }
+  }
+
+  // The aligners are reused between the pairs
+  ColaWorkspace workspace;
   for (i=0; i<target.isize(); i++) {
     for (j=0; j<query.isize(); j++) {
-      if (bAll || i==j) {
-        Cola cola1 = Cola();
-        if(gapOpenPen && mismatchPen && gapExtPen) {
-          cola1.createAlignment(target[i], query[j],
-             AlignerParams(banded, aType, -gapOpenPen, -mismatchPen, -gapExtPen));
-        } else { // If params are not given, use default mode
-          cola1.createAlignment(target[i], query[j], AlignerParams(banded, aType));
+      if (bAll) {
+        const ColaBatchResult& result = batchResults[j][i];
+        if(result.isHit) {
+          Alignment cAlgn = result.alignment.getExpanded();
+          cout << target.Name(i) << " vs " << query.Name(j) << endl;
+          cAlgn.print(0,1,cout,100);
+        } else {
+          cout<<"No Alignment at given significance threshold"<<endl;
         }
-        Alignment cAlgn = cola1.getAlignment();
-        if(cAlgn.calcPVal()<=maxP && cAlgn.getIdentityScore()>=minIdent) {
+      } else if (i==j) {
+        Cola cola1 = Cola();
+        const AlignmentCola& algn = cola1.createAlignment(workspace, target[i], query[j], params, maxP, minIdent);
+        if(algn.getLength()>0 && algn.calcPVal()<=maxP && algn.getIdentityScore()>=minIdent) {
+          Alignment cAlgn = algn.getExpanded();
           cout << target.Name(i) << " vs " << query.Name(j) << endl;
           cAlgn.print(0,1,cout,100);
         } else {
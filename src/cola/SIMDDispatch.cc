@@ -0,0 +1,68 @@
+#ifndef FORCE_DEBUG
+#define NDEBUG
+#endif
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "SIMDDispatch.h"
+
+using namespace std;
+
+//=====================================================================
+static const char* s_levelNames[] = { "scalar", "sse4.1", "avx2", "avx512bw" };
+
+/** The most capable instruction set the CPU (and the OS, for the wider registers) supports */
+static SIMDLevel detectSIMDLevel() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx512bw")) { return SIMD_AVX512BW; }
+  if(__builtin_cpu_supports("avx2"))     { return SIMD_AVX2; }
+  if(__builtin_cpu_supports("sse4.1"))   { return SIMD_SSE41; }
+#endif
+  return SIMD_SCALAR;
+}
+
+/** The instruction set to run with and whether it was forced by COLA_SIMD */
+struct SIMDSelection
+{
+  SIMDSelection(): level(detectSIMDLevel()), forced(false) {
+    const char* request = getenv("COLA_SIMD");
+    if(request == NULL || *request == '\0') { return; }
+    for(int l=SIMD_SCALAR; l<=SIMD_AVX512BW; l++) {
+      if(strcmp(request, s_levelNames[l]) != 0) { continue; }
+      forced = true;
+      if(l > level) {
+        cerr << "Warning: COLA_SIMD=" << request << " is not supported by this CPU, using "
+             << s_levelNames[level] << endl;
+      } else {
+        level = (SIMDLevel)l;
+      }
+      return;
+    }
+    cerr << "Warning: unknown COLA_SIMD=" << request << " (expected scalar, sse4.1, avx2 or avx512bw), using "
+         << s_levelNames[level] << endl;
+  }
+
+  SIMDLevel level; /// The instruction set the kernels run with
+  bool forced;     /// Whether it was given by COLA_SIMD rather than found for the CPU
+};
+
+static const SIMDSelection& getSIMDSelection() {
+  static const SIMDSelection selection;
+  return selection;
+}
+
+SIMDLevel getSIMDLevel() {
+  return getSIMDSelection().level;
+}
+
+SIMDLevel getSIMDLevel(SIMDLevel widest) {
+  const SIMDSelection& selection = getSIMDSelection();
+  if(selection.forced || selection.level<widest) { return selection.level; }
+  return widest;
+}
+
+const char* getSIMDLevelName(SIMDLevel level) {
+  return s_levelNames[level];
+}
@@ -0,0 +1,29 @@
+#ifndef _SIMDDISPATCH_H_
+#define _SIMDDISPATCH_H_
+
+/**
+ * The instruction sets the SIMD kernels are built for, from the least to the
+ * most capable. Each kernel has a translation unit per instruction set compiled
+ * with its own target flags (see SIMDops.h) and the one to run is chosen at
+ * runtime, so a single binary runs on any x86 CPU and uses what it has.
+ * SIMD_SCALAR leaves everything to the node by node aligner traversals.
+ */
+enum SIMDLevel { SIMD_SCALAR, SIMD_SSE41, SIMD_AVX2, SIMD_AVX512BW };
+
+/**
+ * The instruction set the kernels run with, found with cpuid on the first call.
+ * For benchmarking, the COLA_SIMD environment variable (scalar, sse4.1, avx2 or
+ * avx512bw) forces the given one, it is never raised past what the CPU supports.
+ */
+SIMDLevel getSIMDLevel();
+
+/**
+ * The instruction set for a kernel whose variants past the given one do not pay off,
+ * i.e. getSIMDLevel capped at it, unless COLA_SIMD forces the instruction set.
+ */
+SIMDLevel getSIMDLevel(SIMDLevel widest);
+
+/** The name of an instruction set, as given in COLA_SIMD */
+const char* getSIMDLevelName(SIMDLevel level);
+
+#endif //_SIMDDISPATCH_H_
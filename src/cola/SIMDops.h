@@ -0,0 +1,348 @@
+#ifndef _SIMDOPS_H_
+#define _SIMDOPS_H_
+
+/**
+ * The SIMD kernels are written once against the vector operations below
+ * and instantiated in a translation unit per instruction set, as each has
+ * to be compiled with its own target flags (e.g. StripedSWGAsse41.cc and
+ * StripedSWGAavx2.cc), the one to run is chosen by getSIMDLevel (see
+ * SIMDDispatch.h). This header should only be included from those.
+ */
+
+#include <climits>
+
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+
+//=====================================================================
+/** Vector operations on 8 lanes of 16-bit scores */
+struct SSE41ops
+{
+  typedef __m128i vec;
+  typedef short elem;
+  static const int LANES = 8;
+  static const elem MIN_VALUE = SHRT_MIN;
+  static const elem MAX_VALUE = SHRT_MAX;
+
+  static vec set1(short x)                 { return _mm_set1_epi16(x); }
+  static vec load(const short* p)          { return _mm_loadu_si128((const __m128i*)p); }
+  static void store(short* p, vec v)       { _mm_storeu_si128((__m128i*)p, v); }
+  static vec adds(vec a, vec b)            { return _mm_adds_epi16(a, b); }
+  static vec max(vec a, vec b)             { return _mm_max_epi16(a, b); }
+  static vec min(vec a, vec b)             { return _mm_min_epi16(a, b); }
+  static vec cmpeq(vec a, vec b)           { return _mm_cmpeq_epi16(a, b); }
+  static vec cmpgt(vec a, vec b)           { return _mm_cmpgt_epi16(a, b); }
+  /** Take the lanes of a where the mask is set and those of b elsewhere */
+  static vec select(vec mask, vec a, vec b) { return _mm_blendv_epi8(b, a, mask); }
+  static bool allEqual(vec a, vec b)       { return _mm_movemask_epi8(_mm_cmpeq_epi16(a, b)) == 0xFFFF; }
+  /** Move every lane up by one, the first lane is set to the given value */
+  static vec shiftIn(vec v, short fill)    { return _mm_insert_epi16(_mm_slli_si128(v, 2), fill, 0); }
+  static short hmax(vec v) {
+    v = _mm_max_epi16(v, _mm_srli_si128(v, 8));
+    v = _mm_max_epi16(v, _mm_srli_si128(v, 4));
+    v = _mm_max_epi16(v, _mm_srli_si128(v, 2));
+    return (short)_mm_extract_epi16(v, 0);
+  }
+  static short hmin(vec v) {
+    v = _mm_min_epi16(v, _mm_srli_si128(v, 8));
+    v = _mm_min_epi16(v, _mm_srli_si128(v, 4));
+    v = _mm_min_epi16(v, _mm_srli_si128(v, 2));
+    return (short)_mm_extract_epi16(v, 0);
+  }
+};
+
+//=====================================================================
+/** Vector operations on 16 lanes of 8-bit scores */
+struct SSE41ops8
+{
+  typedef __m128i vec;
+  typedef signed char elem;
+  static const int LANES = 16;
+  static const elem MIN_VALUE = SCHAR_MIN;
+  static const elem MAX_VALUE = SCHAR_MAX;
+
+  static vec set1(signed char x)           { return _mm_set1_epi8(x); }
+  static vec load(const signed char* p)    { return _mm_loadu_si128((const __m128i*)p); }
+  static void store(signed char* p, vec v) { _mm_storeu_si128((__m128i*)p, v); }
+  static vec adds(vec a, vec b)            { return _mm_adds_epi8(a, b); }
+  static vec max(vec a, vec b)             { return _mm_max_epi8(a, b); }
+  static vec cmpeq(vec a, vec b)           { return _mm_cmpeq_epi8(a, b); }
+  static vec cmpgt(vec a, vec b)           { return _mm_cmpgt_epi8(a, b); }
+  /** Take the lanes of a where the mask is set and those of b elsewhere */
+  static vec select(vec mask, vec a, vec b) { return _mm_blendv_epi8(b, a, mask); }
+  static bool allEqual(vec a, vec b)       { return _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) == 0xFFFF; }
+};
+
+//=====================================================================
+/** Vector operations on 4 lanes of 32-bit scores, add wraps around while adds saturates */
+struct SSE41ops32
+{
+  typedef __m128i vec;
+  typedef int elem;
+  static const int LANES = 4;
+  static const elem MIN_VALUE = INT_MIN;
+  static const elem MAX_VALUE = INT_MAX;
+
+  static vec set1(int x)                   { return _mm_set1_epi32(x); }
+  /** The index of every lane */
+  static vec iota()                        { return _mm_setr_epi32(0, 1, 2, 3); }
+  static vec load(const int* p)            { return _mm_loadu_si128((const __m128i*)p); }
+  static void store(int* p, vec v)         { _mm_storeu_si128((__m128i*)p, v); }
+  static vec add(vec a, vec b)             { return _mm_add_epi32(a, b); }
+  /** There is no saturating 32-bit add, the sum saturates where both operands have the sign it lacks */
+  static vec adds(vec a, vec b) {
+    vec sum = _mm_add_epi32(a, b);
+    vec overflow = _mm_srai_epi32(_mm_andnot_si128(_mm_xor_si128(a, b), _mm_xor_si128(a, sum)), 31);
+    return select(overflow, _mm_xor_si128(_mm_srai_epi32(a, 31), _mm_set1_epi32(INT_MAX)), sum);
+  }
+  static vec sub(vec a, vec b)             { return _mm_sub_epi32(a, b); }
+  static vec max(vec a, vec b)             { return _mm_max_epi32(a, b); }
+  static vec cmpeq(vec a, vec b)           { return _mm_cmpeq_epi32(a, b); }
+  static vec cmpgt(vec a, vec b)           { return _mm_cmpgt_epi32(a, b); }
+  static vec andv(vec a, vec b)            { return _mm_and_si128(a, b); }
+  static vec orv(vec a, vec b)             { return _mm_or_si128(a, b); }
+  /** The lanes of b where the mask is not set */
+  static vec andnot(vec mask, vec b)       { return _mm_andnot_si128(mask, b); }
+  /** Take the lanes of a where the mask is set and those of b elsewhere */
+  static vec select(vec mask, vec a, vec b) { return _mm_blendv_epi8(b, a, mask); }
+  /** A bit per lane of a mask, set for the lanes whose mask is set */
+  static int movemask(vec mask)            { return _mm_movemask_ps(_mm_castsi128_ps(mask)); }
+  static bool allEqual(vec a, vec b)       { return _mm_movemask_epi8(_mm_cmpeq_epi32(a, b)) == 0xFFFF; }
+  static int hmax(vec v) {
+    v = _mm_max_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_max_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(v);
+  }
+};
+#endif //__SSE4_1__
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+//=====================================================================
+/** Vector operations on 16 lanes of 16-bit scores */
+struct AVX2ops
+{
+  typedef __m256i vec;
+  typedef short elem;
+  static const int LANES = 16;
+  static const elem MIN_VALUE = SHRT_MIN;
+  static const elem MAX_VALUE = SHRT_MAX;
+
+  static vec set1(short x)                 { return _mm256_set1_epi16(x); }
+  static vec load(const short* p)          { return _mm256_loadu_si256((const __m256i*)p); }
+  static void store(short* p, vec v)       { _mm256_storeu_si256((__m256i*)p, v); }
+  static vec adds(vec a, vec b)            { return _mm256_adds_epi16(a, b); }
+  static vec max(vec a, vec b)             { return _mm256_max_epi16(a, b); }
+  static vec min(vec a, vec b)             { return _mm256_min_epi16(a, b); }
+  static vec cmpeq(vec a, vec b)           { return _mm256_cmpeq_epi16(a, b); }
+  static vec cmpgt(vec a, vec b)           { return _mm256_cmpgt_epi16(a, b); }
+  /** Take the lanes of a where the mask is set and those of b elsewhere */
+  static vec select(vec mask, vec a, vec b) { return _mm256_blendv_epi8(b, a, mask); }
+  static bool allEqual(vec a, vec b)       { return _mm256_movemask_epi8(_mm256_cmpeq_epi16(a, b)) == -1; }
+  /** Move every lane up by one (across the two 128-bit halves), the first lane is set to the given value */
+  static vec shiftIn(vec v, short fill) {
+    vec lowToHigh = _mm256_permute2x128_si256(v, v, 0x08);
+    return _mm256_insert_epi16(_mm256_alignr_epi8(v, lowToHigh, 14), fill, 0);
+  }
+  static short hmax(vec v) {
+    __m128i m = _mm_max_epi16(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    m = _mm_max_epi16(m, _mm_srli_si128(m, 8));
+    m = _mm_max_epi16(m, _mm_srli_si128(m, 4));
+    m = _mm_max_epi16(m, _mm_srli_si128(m, 2));
+    return (short)_mm_extract_epi16(m, 0);
+  }
+  static short hmin(vec v) {
+    __m128i m = _mm_min_epi16(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    m = _mm_min_epi16(m, _mm_srli_si128(m, 8));
+    m = _mm_min_epi16(m, _mm_srli_si128(m, 4));
+    m = _mm_min_epi16(m, _mm_srli_si128(m, 2));
+    return (short)_mm_extract_epi16(m, 0);
+  }
+};
+
+//=====================================================================
+/** Vector operations on 32 lanes of 8-bit scores */
+struct AVX2ops8
+{
+  typedef __m256i vec;
+  typedef signed char elem;
+  static const int LANES = 32;
+  static const elem MIN_VALUE = SCHAR_MIN;
+  static const elem MAX_VALUE = SCHAR_MAX;
+
+  static vec set1(signed char x)           { return _mm256_set1_epi8(x); }
+  static vec load(const signed char* p)    { return _mm256_loadu_si256((const __m256i*)p); }
+  static void store(signed char* p, vec v) { _mm256_storeu_si256((__m256i*)p, v); }
+  static vec adds(vec a, vec b)            { return _mm256_adds_epi8(a, b); }
+  static vec max(vec a, vec b)             { return _mm256_max_epi8(a, b); }
+  static vec cmpeq(vec a, vec b)           { return _mm256_cmpeq_epi8(a, b); }
+  static vec cmpgt(vec a, vec b)           { return _mm256_cmpgt_epi8(a, b); }
+  /** Take the lanes of a where the mask is set and those of b elsewhere */
+  static vec select(vec mask, vec a, vec b) { return _mm256_blendv_epi8(b, a, mask); }
+  static bool allEqual(vec a, vec b)       { return _mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)) == -1; }
+};
+
+//=====================================================================
+/** Vector operations on 8 lanes of 32-bit scores, add wraps around while adds saturates */
+struct AVX2ops32
+{
+  typedef __m256i vec;
+  typedef int elem;
+  static const int LANES = 8;
+  static const elem MIN_VALUE = INT_MIN;
+  static const elem MAX_VALUE = INT_MAX;
+
+  static vec set1(int x)                   { return _mm256_set1_epi32(x); }
+  /** The index of every lane */
+  static vec iota()                        { return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7); }
+  static vec load(const int* p)            { return _mm256_loadu_si256((const __m256i*)p); }
+  static void store(int* p, vec v)         { _mm256_storeu_si256((__m256i*)p, v); }
+  static vec add(vec a, vec b)             { return _mm256_add_epi32(a, b); }
+  /** There is no saturating 32-bit add, the sum saturates where both operands have the sign it lacks */
+  static vec adds(vec a, vec b) {
+    vec sum = _mm256_add_epi32(a, b);
+    vec overflow = _mm256_srai_epi32(_mm256_andnot_si256(_mm256_xor_si256(a, b), _mm256_xor_si256(a, sum)), 31);
+    return select(overflow, _mm256_xor_si256(_mm256_srai_epi32(a, 31), _mm256_set1_epi32(INT_MAX)), sum);
+  }
+  static vec sub(vec a, vec b)             { return _mm256_sub_epi32(a, b); }
+  static vec max(vec a, vec b)             { return _mm256_max_epi32(a, b); }
+  static vec cmpeq(vec a, vec b)           { return _mm256_cmpeq_epi32(a, b); }
+  static vec cmpgt(vec a, vec b)           { return _mm256_cmpgt_epi32(a, b); }
+  static vec andv(vec a, vec b)            { return _mm256_and_si256(a, b); }
+  static vec orv(vec a, vec b)             { return _mm256_or_si256(a, b); }
+  /** The lanes of b where the mask is not set */
+  static vec andnot(vec mask, vec b)       { return _mm256_andnot_si256(mask, b); }
+  /** Take the lanes of a where the mask is set and those of b elsewhere */
+  static vec select(vec mask, vec a, vec b) { return _mm256_blendv_epi8(b, a, mask); }
+  /** A bit per lane of a mask, set for the lanes whose mask is set */
+  static int movemask(vec mask)            { return _mm256_movemask_ps(_mm256_castsi256_ps(mask)); }
+  static bool allEqual(vec a, vec b)       { return _mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b)) == -1; }
+  static int hmax(vec v) {
+    __m128i m = _mm_max_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    m = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(m);
+  }
+};
+#endif //__AVX2__
+
+#if defined(__AVX512BW__)
+#include <immintrin.h>
+
+// The kernels work on vector masks (a lane of all ones or all zeros) as in the narrower
+// instruction sets, comparisons expand the mask registers into them and selecting is
+// done bitwise (ternary logic 0xCA: mask? a : b).
+
+//=====================================================================
+/** Vector operations on 32 lanes of 16-bit scores */
+struct AVX512ops
+{
+  typedef __m512i vec;
+  typedef short elem;
+  static const int LANES = 32;
+  static const elem MIN_VALUE = SHRT_MIN;
+  static const elem MAX_VALUE = SHRT_MAX;
+
+  static vec set1(short x)                 { return _mm512_set1_epi16(x); }
+  static vec load(const short* p)          { return _mm512_loadu_si512((const void*)p); }
+  static void store(short* p, vec v)       { _mm512_storeu_si512((void*)p, v); }
+  static vec adds(vec a, vec b)            { return _mm512_adds_epi16(a, b); }
+  static vec max(vec a, vec b)             { return _mm512_max_epi16(a, b); }
+  static vec min(vec a, vec b)             { return _mm512_min_epi16(a, b); }
+  static vec cmpeq(vec a, vec b)           { return _mm512_movm_epi16(_mm512_cmpeq_epi16_mask(a, b)); }
+  static vec cmpgt(vec a, vec b)           { return _mm512_movm_epi16(_mm512_cmpgt_epi16_mask(a, b)); }
+  /** Take the lanes of a where the mask is set and those of b elsewhere */
+  static vec select(vec mask, vec a, vec b) { return _mm512_ternarylogic_epi32(mask, a, b, 0xCA); }
+  static bool allEqual(vec a, vec b)       { return _mm512_cmpneq_epi16_mask(a, b) == 0; }
+  /** Move every lane up by one (across the 128-bit blocks), the first lane is set to the given value */
+  static vec shiftIn(vec v, short fill) {
+    static const short up[LANES] = { 0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+                                     15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30 };
+    return _mm512_mask_set1_epi16(_mm512_permutexvar_epi16(load(up), v), 1, fill);
+  }
+  static short hmax(vec v) {
+    __m256i h = _mm256_max_epi16(_mm512_castsi512_si256(v), _mm512_extracti64x4_epi64(v, 1));
+    __m128i m = _mm_max_epi16(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1));
+    m = _mm_max_epi16(m, _mm_srli_si128(m, 8));
+    m = _mm_max_epi16(m, _mm_srli_si128(m, 4));
+    m = _mm_max_epi16(m, _mm_srli_si128(m, 2));
+    return (short)_mm_extract_epi16(m, 0);
+  }
+  static short hmin(vec v) {
+    __m256i h = _mm256_min_epi16(_mm512_castsi512_si256(v), _mm512_extracti64x4_epi64(v, 1));
+    __m128i m = _mm_min_epi16(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1));
+    m = _mm_min_epi16(m, _mm_srli_si128(m, 8));
+    m = _mm_min_epi16(m, _mm_srli_si128(m, 4));
+    m = _mm_min_epi16(m, _mm_srli_si128(m, 2));
+    return (short)_mm_extract_epi16(m, 0);
+  }
+};
+
+//=====================================================================
+/** Vector operations on 64 lanes of 8-bit scores */
+struct AVX512ops8
+{
+  typedef __m512i vec;
+  typedef signed char elem;
+  static const int LANES = 64;
+  static const elem MIN_VALUE = SCHAR_MIN;
+  static const elem MAX_VALUE = SCHAR_MAX;
+
+  static vec set1(signed char x)           { return _mm512_set1_epi8(x); }
+  static vec load(const signed char* p)    { return _mm512_loadu_si512((const void*)p); }
+  static void store(signed char* p, vec v) { _mm512_storeu_si512((void*)p, v); }
+  static vec adds(vec a, vec b)            { return _mm512_adds_epi8(a, b); }
+  static vec max(vec a, vec b)             { return _mm512_max_epi8(a, b); }
+  static vec cmpeq(vec a, vec b)           { return _mm512_movm_epi8(_mm512_cmpeq_epi8_mask(a, b)); }
+  static vec cmpgt(vec a, vec b)           { return _mm512_movm_epi8(_mm512_cmpgt_epi8_mask(a, b)); }
+  /** Take the lanes of a where the mask is set and those of b elsewhere */
+  static vec select(vec mask, vec a, vec b) { return _mm512_ternarylogic_epi32(mask, a, b, 0xCA); }
+  static bool allEqual(vec a, vec b)       { return _mm512_cmpneq_epi8_mask(a, b) == 0; }
+};
+
+//=====================================================================
+/** Vector operations on 16 lanes of 32-bit scores, add wraps around while adds saturates */
+struct AVX512ops32
+{
+  typedef __m512i vec;
+  typedef int elem;
+  static const int LANES = 16;
+  static const elem MIN_VALUE = INT_MIN;
+  static const elem MAX_VALUE = INT_MAX;
+
+  /** AVX-512BW has no conversion between 32-bit vector masks and mask registers, the lanes are tested instead */
+  static __mmask16 toMask(vec mask)        { return _mm512_test_epi32_mask(mask, mask); }
+  static vec fromMask(__mmask16 k)         { return _mm512_maskz_set1_epi32(k, -1); }
+
+  static vec set1(int x)                   { return _mm512_set1_epi32(x); }
+  /** The index of every lane */
+  static vec iota()                        { return _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0); }
+  static vec load(const int* p)            { return _mm512_loadu_si512((const void*)p); }
+  static void store(int* p, vec v)         { _mm512_storeu_si512((void*)p, v); }
+  static vec add(vec a, vec b)             { return _mm512_add_epi32(a, b); }
+  /** There is no saturating 32-bit add, the sum saturates where both operands have the sign it lacks */
+  static vec adds(vec a, vec b) {
+    vec sum = _mm512_add_epi32(a, b);
+    vec signs = _mm512_andnot_si512(_mm512_xor_si512(a, b), _mm512_xor_si512(a, sum));
+    __mmask16 overflow = _mm512_cmplt_epi32_mask(signs, _mm512_setzero_si512());
+    return _mm512_mask_blend_epi32(overflow, sum, _mm512_xor_si512(_mm512_srai_epi32(a, 31), _mm512_set1_epi32(INT_MAX)));
+  }
+  static vec sub(vec a, vec b)             { return _mm512_sub_epi32(a, b); }
+  static vec max(vec a, vec b)             { return _mm512_max_epi32(a, b); }
+  static vec cmpeq(vec a, vec b)           { return fromMask(_mm512_cmpeq_epi32_mask(a, b)); }
+  static vec cmpgt(vec a, vec b)           { return fromMask(_mm512_cmpgt_epi32_mask(a, b)); }
+  static vec andv(vec a, vec b)            { return _mm512_and_si512(a, b); }
+  static vec orv(vec a, vec b)             { return _mm512_or_si512(a, b); }
+  /** The lanes of b where the mask is not set */
+  static vec andnot(vec mask, vec b)       { return _mm512_andnot_si512(mask, b); }
+  /** Take the lanes of a where the mask is set and those of b elsewhere */
+  static vec select(vec mask, vec a, vec b) { return _mm512_ternarylogic_epi32(mask, a, b, 0xCA); }
+  /** A bit per lane of a mask, set for the lanes whose mask is set */
+  static int movemask(vec mask)            { return toMask(mask); }
+  static bool allEqual(vec a, vec b)       { return _mm512_cmpneq_epi32_mask(a, b) == 0; }
+  static int hmax(vec v)                   { return _mm512_reduce_max_epi32(v); }
+};
+#endif //__AVX512BW__
+
+#endif //_SIMDOPS_H_
@@ -4,53 +4,50 @@
 
 #include "SWGAaligner.h"
 
-void SWGAaligner::visitNode(EditGraphNode* currNode, int  currCheckpointColIndex) {
-  int i = currNode->getRow();
-  int j = currNode->getCol();
-  int k = currNode->getDepth(); 
-  double s, score1, score2;
-  switch(k) {
-  case 0:  //Moving vertically
-    score1 = editGraph.getNode(i-1, j, k)->getScore() + params.getGapExtP();
-    score2 = editGraph.getBestScoreAtRowCol(i-1, j) + params.getGapOpenP();  
-    if(score1>score2) {
-      currNode->setScore(score1);
-      currNode->setCPACords(editGraph.getNode(i-1, j, k),
-        currCheckpointColIndex);
-    } else {
-      currNode->setScore(score2);
-      currNode->setCPACords(editGraph.getBestNodeAtRowCol(i-1, j),
-        currCheckpointColIndex);
-    }
-    break;
-  case 1:  //Moving horizontally
-    score1 = editGraph.getNode(i, j-1, k)->getScore() + params.getGapExtP();
-    score2 = editGraph.getBestScoreAtRowCol(i, j-1) + params.getGapOpenP();  
-    if(score1>score2) {
-      currNode->setScore(score1);
-      currNode->setCPACords(editGraph.getNode(i, j-1, k),
-        currCheckpointColIndex);
-    } else {
-      currNode->setScore(score2);
-      currNode->setCPACords(editGraph.getBestNodeAtRowCol(i, j-1),
-        currCheckpointColIndex);
-    }
-    break;
-  case 2: //Moving diagonally
-    s = editGraph.getBestScoreAtRowCol(i-1,j-1);
-    if( getTargetSeq()[j] == getQuerySeq()[i] ) {
-      // The scoring is uniform for SW as opposed to NS
-      if(i*j==0 && s==MINUS_INF) { s = 0; } // special case for first row/column
-      currNode->setScore(s + 1);
-    } else {
-      currNode->setScore(s + params.getMismatchP());
-    }
-    currNode->setCPACords(editGraph.getBestNodeAtRowCol(i-1, j-1),
-      currCheckpointColIndex);
-    break;
-  default: 
-    currNode->setScore(MINUS_INF);
+double SWGAaligner::visitColumns(int startRow, int startCol, int endRow, int endCol,
+       int currCheckpointColIndex, bool findBestNode) {
+  // The kernel keeps full columns and no parents, banded alignment, X-drop and
+  // traced sections are visited node by node
+  if(editGraph.isBanded() || isXDropped(findBestNode) || currCheckpointColIndex==TRACK_PARENTS) {
+    return visitColumnsOf<SWGAaligner>(startRow, startCol, endRow, endCol, currCheckpointColIndex, findBestNode);
+  }
+  const EditGraphColumn* startColumn = editGraph.getColumn(startCol);
+  ColaScore startBest = startColumn->getBestScore(startRow);
+  ColaScore startHz   = startColumn->getScore(startRow, 1);
+  StripedTraversal trav(startRow, startCol, endRow, endCol, currCheckpointColIndex, findBestNode,
+                        toStripedScore(startBest), toStripedScore(startHz));
+  trav.trackOrigin = (currCheckpointColIndex == TRACK_ORIGIN);
+  StripedSWGA kernel(params);
+  if(startBest>=SHRT_MAX || !kernel.traverse(getTargetSeq(), getQuerySeq(), trav)) {
+    return visitColumnsOf<SWGAaligner>(startRow, startCol, endRow, endCol, currCheckpointColIndex, findBestNode);
   }
-} 
 
+  // The score-only pass only needs the best node, which keeps its origin
+  if(trav.trackOrigin) {
+    editGraph.updateBest(EditGraphNode(startRow + trav.bestRow, trav.bestCol, trav.bestDepth, trav.bestScore,
+                                       startRow + trav.bestCPArow, trav.bestCPAdepth));
+    return (double)(endCol-startCol) * (endRow-startRow+1) * (editGraph.maxContigDepth+1);
+  }
 
+  // Only the checkpoint and end columns are needed by the recursion
+  editGraph.checkpointCol.setDiagonal(currCheckpointColIndex);
+  editGraph.initCol(endCol, startRow, endRow);
+  EditGraphColumn* endColumn = editGraph.getColumn(endCol);
+  for(int row=startRow; row<=endRow; row++) {
+    int idx = trav.getIndex(row-startRow);
+    editGraph.checkpointCol.initCell(row);
+    for(int depth=0; depth<STRIPED_NUM_DEPTHS; depth++) {
+      editGraph.checkpointCol.setNode(row, depth, fromStripedScore(trav.checkpointScores[depth][idx]), row, depth);
+      endColumn->setNode(row, depth, fromStripedScore(trav.endScores[depth][idx]),
+                         startRow + trav.endCPArows[depth][idx], trav.endCPAdepths[depth][idx]);
+    }
+    editGraph.checkpointCol.setBestDepth(row, getBestStripedDepth(trav.checkpointScores, idx));
+    endColumn->setBestDepth(row, getBestStripedDepth(trav.endScores, idx));
+  }
+  if(findBestNode) {
+    editGraph.updateBest(EditGraphNode(startRow + trav.bestRow, trav.bestCol, trav.bestDepth, trav.bestScore,
+                                       startRow + trav.bestCPArow, trav.bestCPAdepth));
+  }
+  // All depths are visited for each cell
+  return (double)(endCol-startCol) * (endRow-startRow+1) * (editGraph.maxContigDepth+1);
+}
@@ -2,9 +2,11 @@
 #define _SWGAALIGNER_H_
 
 #include "NSaligner.h"
+#include "StripedSWGA.h"
 
 class SWGAaligner: public NSaligner 
 {
+  friend class NSaligner; // For visiting the nodes in traverseColumns
 public:
   /** 
    * @param[in]  The target sequence
@@ -20,13 +22,99 @@ public:
   ~SWGAaligner() {}
 
 protected:
+  /** Returns a copy of this aligner (see NSaligner::clone) */
+  virtual NSaligner* clone() const { return new SWGAaligner(*this); }
+
+  /**
+   * Overrides the visitColumns function in the parent class (i.e. NSaligner)
+   * to score the columns with the striped SIMD kernel. The kernel is used for
+   * unbanded alignment, smaller sections of the graph are visited node by node.
+   */
+  virtual double visitColumns(int startRow, int startCol, int endRow, int endCol,
+       int currCheckpointColIndex, bool findBestNode);
+
+  /** Matches are scored linearly */
+  virtual int getMinMatchScore() const { return 1; }
+
+  /** Unbanded sections are scored faster by the striped kernel than traced node by node, even checkpointed */
+  virtual bool isTraced(int startRow, int startCol, int endRow, int endCol) const {
+    return editGraph.isBanded() && NSaligner::isTraced(startRow, startCol, endRow, endCol);
+  }
+
+  /** Conversion of scores between the edit graph and the striped kernel */
+  short     toStripedScore(ColaScore s) const { return (s==MINUS_INF)? STRIPED_NEG_INF : (short)min(s, (ColaScore)SHRT_MAX); }
+  ColaScore fromStripedScore(short s) const   { return (s==STRIPED_NEG_INF)? MINUS_INF : s; }
+
+  /** The depth of the best node of a cell in the striped columns, i.e. the first holding the maximum */
+  int getBestStripedDepth(const vector<short>* scores, int idx) const {
+    int best = 0;
+    for(int depth=1; depth<STRIPED_NUM_DEPTHS; depth++) {
+      if(scores[depth][idx]>scores[best][idx]) { best = depth; }
+    }
+    return best;
+  }
+
   /** 
-   * Overrides the visitNode function in the parent class (i.e. NSaligner)
+   * Hides the visitNode function in the parent class (i.e. NSaligner)
+   * N.B. Defined below so that NSGAaligner can inline it too
    * @param[in]  The node to be visited 
    * @param[in] Index of column that should be checkpointed in current iteration
+   * @param ORIGIN: Whether the origin is kept instead of the checkpoint ancestor
    */
-  virtual  void visitNode(EditGraphNode* currNode, int currCheckpointColIndex); 
+  template<bool ORIGIN>
+  void visitNode(EditGraphNode* currNode, int currCheckpointColIndex); 
 };
 
+//=====================================================================
+template<bool ORIGIN>
+inline void SWGAaligner::visitNode(EditGraphNode* currNode, int  currCheckpointColIndex) {
+  int i = currNode->getRow();
+  int j = currNode->getCol();
+  int k = currNode->getDepth(); 
+  ColaScore s, score1, score2;
+  switch(k) {
+  case 0:  //Moving vertically
+    score1 = addScore(editGraph.getScore(i-1, j, k), params.getGapExtP());
+    score2 = addScore(editGraph.getBestScoreAtRowCol(i-1, j), params.getGapOpenP());
+    if(score1>score2) {
+      currNode->setScore(score1);
+      currNode->setAncestorCords<ORIGIN>(editGraph.getNode(i-1, j, k),
+        currCheckpointColIndex);
+    } else {
+      currNode->setScore(score2);
+      currNode->setAncestorCords<ORIGIN>(editGraph.getBestNodeAtRowCol(i-1, j),
+        currCheckpointColIndex);
+    }
+    break;
+  case 1:  //Moving horizontally
+    score1 = addScore(editGraph.getScore(i, j-1, k), params.getGapExtP());
+    score2 = addScore(editGraph.getBestScoreAtRowCol(i, j-1), params.getGapOpenP());
+    if(score1>score2) {
+      currNode->setScore(score1);
+      currNode->setAncestorCords<ORIGIN>(editGraph.getNode(i, j-1, k),
+        currCheckpointColIndex);
+    } else {
+      currNode->setScore(score2);
+      currNode->setAncestorCords<ORIGIN>(editGraph.getBestNodeAtRowCol(i, j-1),
+        currCheckpointColIndex);
+    }
+    break;
+  case 2: //Moving diagonally
+    s = editGraph.getBestScoreAtRowCol(i-1,j-1);
+    if( alignment.getTargetSeq()[j] == alignment.getQuerySeq()[i] ) {
+      // The scoring is uniform for SW as opposed to NS
+      if(i*j==0 && s==MINUS_INF) { s = 0; } // special case for first row/column
+      currNode->setScore(addScore(s, 1));
+    } else {
+      currNode->setScore(addScore(s, params.getMismatchP()));
+    }
+    currNode->setAncestorCords<ORIGIN>(editGraph.getBestNodeAtRowCol(i-1, j-1),
+      currCheckpointColIndex);
+    break;
+  default: 
+    currNode->setScore(MINUS_INF);
+  }
+}
+
 
 #endif //_SWGAALIGNER_H_
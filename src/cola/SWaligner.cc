@@ -0,0 +1,267 @@
+#ifndef FORCE_DEBUG
+#define NDEBUG
+#endif
+
+#include "SWaligner.h"
+
+
+//=====================================================================
+SWaligner::SWaligner(const DNAVector& tSeq, const DNAVector& qSeq, const AlignerParams& p)
+  :bandWidth(p.getBandWidth()), adaptiveBand(false), bandCenters(), scores(qSeq.size()+1, MINUS_INF),
+   ancestorRows(qSeq.size()+1, 0), originCols(), checkpointScores(qSeq.size()+1, MINUS_INF), bestScoredNode(),
+   alignment(tSeq, qSeq, p), params(p) {
+  //If bandwidth has not been provided, default is to run in unbanded mode
+  if(bandWidth<0) { bandWidth = max(tSeq.isize(), qSeq.isize()); }
+  adaptiveBand = p.isAdaptiveBand() && bandWidth<max(tSeq.isize(), qSeq.isize());
+  bandCenters.assign(adaptiveBand? tSeq.isize()+2 : 0, 0);
+  // The gap row is never visited, paths entering the first row from it have no checkpoint ancestor
+  ancestorRows[getIndex(-1)] = -1;
+}
+
+const AlignmentCola& SWaligner::align() {
+  return align(0, 0, getTargetSeq().isize(), getQuerySeq().isize());
+}
+
+const AlignmentCola& SWaligner::align(int targetStartIdx, int queryStartIdx, int targetStopIdx, int queryStopIdx) {
+  // No alignment can be performed if any of the query or target sequences are of 0 size
+  if(!alignment.getTargetSeq().isize() || !alignment.getQuerySeq().isize()) { return alignment; }
+  double runtime = time(NULL);
+  // The path has at most a node per anti-diagonal of the section
+  alignment.reservePath(targetStopIdx-targetStartIdx + queryStopIdx-queryStartIdx + 1);
+  double colaRuntimeFactor = traverseGraph(queryStartIdx, targetStartIdx-1, queryStopIdx-1, targetStopIdx-1,
+                          true, 0);
+  alignment.traceAlignment();
+  runtime = time(NULL) - runtime;
+  alignment.setRuntime(runtime);
+  alignment.setRuntimeFactor(colaRuntimeFactor);
+  return alignment;
+}
+
+AlignmentScore SWaligner::score(int targetStartIdx, int queryStartIdx, int targetStopIdx, int queryStopIdx) {
+  if(!alignment.getTargetSeq().isize() || !alignment.getQuerySeq().isize()) { return AlignmentScore(); }
+  originCols.assign(scores.size(), 0);
+  startBand(queryStartIdx, targetStartIdx-1);
+  initColumn(queryStartIdx, queryStopIdx-1, 0);
+  bestScoredNode.setScore(MINUS_INF);
+  visitColumns<true>(queryStartIdx, targetStartIdx-1, queryStopIdx-1, targetStopIdx-1, TRACK_ORIGIN, true);
+  if(bestScoredNode.getScore()<=0) { return AlignmentScore(); }
+  AlignmentScore result(bestScoredNode.getScore(), bestScoredNode.getCPADepth(), bestScoredNode.getCPARow(),
+                        bestScoredNode.getCol(), bestScoredNode.getRow());
+  result.setScoreBound(1, -min(params.getGapOpenP(), params.getMismatchP()));
+  return result;
+}
+
+void SWaligner::reset(const DNAVector& tSeq, const DNAVector& qSeq, const AlignerParams& p) {
+  bandWidth = p.getBandWidth();
+  if(bandWidth<0) { bandWidth = max(tSeq.isize(), qSeq.isize()); }
+  adaptiveBand = p.isAdaptiveBand() && bandWidth<max(tSeq.isize(), qSeq.isize());
+  bandCenters.assign(adaptiveBand? tSeq.isize()+2 : 0, 0);
+  scores.assign(qSeq.size()+1, MINUS_INF);
+  ancestorRows.assign(qSeq.size()+1, 0);
+  ancestorRows[getIndex(-1)] = -1;
+  originCols.clear();
+  checkpointScores.assign(qSeq.size()+1, MINUS_INF);
+  bestScoredNode = EditGraphNode();
+  alignment.reset(tSeq, qSeq, p);
+  params = p;
+}
+
+void SWaligner::initColumn(int startRow, int endRow, ColaScore startScore) {
+  for(int row=startRow-1; row<=endRow; row++) { scores[getIndex(row)] = MINUS_INF; }
+  scores[getIndex(startRow)] = startScore;
+}
+
+//=====================================================================
+double SWaligner::traverseGraph(int startRow, int startCol, int endRow, int endCol,
+      bool findEnd, ColaScore startScore) {
+  // 1) Restart from the cell checkpointed by the previous recursion.
+  // An adaptive band starts on the diagonal of the start cell, the first run centers the others.
+  if(findEnd) { startBand(startRow, startCol); }
+  initColumn(startRow, endRow, startScore);
+
+  // 2) Reset the bestScoredNode
+  bestScoredNode.setScore(MINUS_INF);
+
+  // 3) The middle column should be checkpointed
+  int currCheckpointColIndex = (startCol + endCol)/2;
+
+  // 4) Visit the cells column by column
+  double cellsVisited = visitColumns<false>(startRow, startCol, endRow, endCol,
+                      currCheckpointColIndex, findEnd);
+  cellsVisited /= (endRow*endCol);
+
+  // 5) Check if reached end of recursion, the end column is the latest one visited
+  if(startCol+1 == endCol) {
+    // A local alignment within a single column is its best scored match alone
+    if(findEnd) {
+      if(bestScoredNode.getScore()>0) { alignment.addNodeToPath(bestScoredNode); }
+    } else if(endCol!=0) {
+      for(int i=startRow+1; i<endRow; i++) {
+        alignment.addNodeToPath(EditGraphNode(i, endCol, 0, scores[getIndex(i)], ancestorRows[getIndex(i)], 0));
+      }
+    }
+    return cellsVisited;
+  }
+
+  // 6) Track the ancestor cell in the checkpointed column for the target cell
+  int optimalRow;
+  if(!findEnd) {
+    optimalRow = ancestorRows[getIndex(endRow)];
+  } else {
+    optimalRow = bestScoredNode.getCPARow();
+    //Change the coordinates of endNode so that the best cell will become the end node
+    endRow     = bestScoredNode.getRow();
+    endCol     = bestScoredNode.getCol();
+    alignment.addNodeToPath(bestScoredNode);
+    // If the best scoring cell falls before the first checkpointed column:
+    // Rerun function and do not continue to step 7-8
+    if(endCol<currCheckpointColIndex) {
+      if ((startCol+1<endRow ) || (startCol+1==endRow && startRow<=endRow)) {
+        traverseGraph(startRow, startCol, endRow, endCol, false, startScore);
+      }
+      return cellsVisited;
+    }
+  }
+  // 7) Save the checkpointed cell on the optimal path. If the local alignment starts in the
+  // first row after the checkpoint column the recursion goes on from the first row, and the
+  // path node is unreachable so that the alignment is traced from after it.
+  bool startsAfter = (optimalRow<0);
+  if(startsAfter) { optimalRow = 0; }
+  ColaScore checkpointScore = checkpointScores[getIndex(optimalRow)];
+  alignment.addNodeToPath(EditGraphNode(optimalRow, currCheckpointColIndex, 0,
+                                        startsAfter? MINUS_INF : checkpointScore, optimalRow, 0));
+
+  // 8) Continue recursion
+  if ((startCol+1<currCheckpointColIndex ) || (startCol+1==currCheckpointColIndex && startRow<=optimalRow)) {
+    traverseGraph(startRow, startCol, optimalRow, currCheckpointColIndex, false, startScore);
+  }
+  if ((currCheckpointColIndex+1<endCol ) || (currCheckpointColIndex+1==endCol && optimalRow<=endRow)){
+    traverseGraph(optimalRow, currCheckpointColIndex, endRow, endCol, false, checkpointScore);
+  }
+  return cellsVisited;
+}
+
+//=====================================================================
+template<bool ORIGIN>
+double SWaligner::visitColumns(int startRow, int startCol, int endRow, int endCol,
+      int currCheckpointColIndex, bool findBestNode) {
+  const DNAVector& tSeq = getTargetSeq();
+  const DNAVector& qSeq = getQuerySeq();
+  ColaScore gap      = params.getGapOpenP();
+  ColaScore mismatch = params.getMismatchP();
+  double cellsVisited = 0;
+  ColaScore bestScore = bestScoredNode.getScore();
+  // With X-drop a cell scoring more than it below the best cell is dropped, i.e. unreachable. The
+  // columns are visited from the first live row of the previous one, and past its last live row
+  // only while reached from above (see NSaligner::traverseColumnsXDrop)
+  bool xDrop     = findBestNode && params.getXDrop()>=0;
+  ColaScore dropScore = MINUS_INF;
+  int liveStart  = startRow; // The first live row of the previous column
+  int liveEnd    = endRow;   // The last live row of the previous column
+  int visitedEnd = startRow; // The last row visited in the previous column, the rows after it are unreachable
+  for(int col=startCol+1; col<=endCol; col++) {
+    //banded alignment - skip out-of-band cells
+    int center = getBandCenter(col);
+    int start  = max(max(startRow, center-bandWidth), liveStart);
+    int end    = min(endRow, center+bandWidth);
+    if(start>end) { 
+      if(xDrop) { break; }
+      if(findBestNode && adaptiveBand) { centerNextBand(col, start, end); }
+      continue;
+    }
+    // The cell above the first row is unreachable, the diagonal move into the first row reads it before it is reset
+    ColaScore diag = scores[getIndex(start-1)];
+    int diagRow    = ancestorRows[getIndex(start-1)];
+    int diagCol    = ORIGIN? originCols[getIndex(start-1)] : 0;
+    scores[getIndex(start-1)] = MINUS_INF;
+    ColaScore up = MINUS_INF;
+    int upRow = 0, upCol = 0;
+    char targetBase = tSeq[col];
+    int firstLive = -1, lastLive = -1;
+    int row;
+    for(row=start; row<=end; row++) {
+      // Past the live rows of the previous column a cell is only reached from the one above
+      if(row>liveEnd+1 && up==MINUS_INF) { break; }
+      int idx = getIndex(row);
+      ColaScore left = scores[idx];
+      int leftRow    = ancestorRows[idx];
+      int leftCol    = ORIGIN? originCols[idx] : 0;
+
+      // The moves are taken in the order of the depths of SWGAaligner, a move replaces
+      // the previous ones if it scores higher than their score after clipping at zero.
+      ColaScore parentScore = up;
+      int ancRow = upRow, ancCol = upCol;
+      ColaScore score  = addScore(up, gap);
+      ColaScore kept   = (score!=MINUS_INF && score<0)? 0 : score;
+      ColaScore scoreH = addScore(left, gap);
+      if(scoreH > kept) {
+        score = scoreH; kept = (scoreH<0)? 0 : scoreH;
+        parentScore = left; ancRow = leftRow; ancCol = leftCol;
+      }
+      ColaScore scoreD;
+      if(targetBase == qSeq[row]) {
+        ColaScore s = diag;
+        if(row*col==0 && s==MINUS_INF) { s = 0; } // special case for first row/column
+        scoreD = addScore(s, 1);
+      } else {
+        scoreD = addScore(diag, mismatch);
+      }
+      if(scoreD > kept) {
+        score = scoreD; kept = (scoreD<0)? 0 : scoreD;
+        parentScore = diag; ancRow = diagRow; ancCol = diagCol;
+      }
+      if(ORIGIN) {
+        // A cell whose parent has no positive score starts a local alignment
+        if(parentScore<=0) { ancRow = row; ancCol = col; }
+      } else if(col == currCheckpointColIndex) {
+        ancRow = row;
+      }
+      if(findBestNode && (score > bestScore || score == INT_MAX)) {
+        bestScore      = score;
+        bestScoredNode = EditGraphNode(row, col, 0, score, ancRow, ancCol);
+        if(xDrop) { dropScore = bestScore-params.getXDrop(); }
+      }
+      if(kept<dropScore) {
+        kept = MINUS_INF;
+      } else if(kept!=MINUS_INF) {
+        if(firstLive<0) { firstLive = row; }
+        lastLive = row;
+      }
+
+      diag = left; diagRow = leftRow; diagCol = leftCol;
+      scores[idx] = kept;
+      ancestorRows[idx] = ancRow;
+      if(ORIGIN) { originCols[idx] = ancCol; }
+      up = kept; upRow = ancRow; upCol = ancCol;
+    }
+    end = row-1;
+    cellsVisited += end-start+1;
+    //Checkpoint middle column - keep for retrieving the checkpoint cell
+    if(col == currCheckpointColIndex) {
+      for(int row=start; row<=end; row++) { checkpointScores[getIndex(row)] = scores[getIndex(row)]; }
+    }
+    if(findBestNode && adaptiveBand) { centerNextBand(col, start, end); }
+    if(!xDrop) { continue; }
+    if(firstLive<0) { break; } // The whole column is dropped
+    // The rows left from the earlier columns are not reached
+    for(int row=end+1; row<=visitedEnd; row++) { scores[getIndex(row)] = MINUS_INF; }
+    liveStart  = firstLive;
+    liveEnd    = lastLive;
+    visitedEnd = end;
+  }
+  return cellsVisited;
+}
+
+void SWaligner::centerNextBand(int col, int start, int end) {
+  int center  = getBandCenter(col);
+  int bestRow = center;
+  ColaScore bestScore = (center>=start && center<=end)? scores[getIndex(center)] : MINUS_INF;
+  for(int row=start; row<=end; row++) {
+    if(scores[getIndex(row)]>bestScore) {
+      bestScore = scores[getIndex(row)];
+      bestRow   = row;
+    }
+  }
+  // The diagonal of the center goes on one row lower, and is moved a row towards the best cell
+  bandCenters[col+2] = center + 1 + (bestRow>center) - (bestRow<center);
+}
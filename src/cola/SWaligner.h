@@ -0,0 +1,118 @@
+#ifndef _SWALIGNER_H_
+#define _SWALIGNER_H_
+
+#include "EditGraph.h"
+#include "AlignmentCola.h"
+#include "IAligner.h"
+#include "AlignerParams.h"
+
+//=====================================================================
+/**
+ * Smith-Waterman with linear gaps, i.e. the gap open and extension penalties
+ * are the same. As opposed to the other aligners there is no depth to the
+ * cells: each cell holds a single score, the best of the vertical, horizontal,
+ * and diagonal moves into it, and the graph is kept as one column of scores
+ * that is updated in place while moving to the next column.
+ * The checkpointing and recursion follow NSaligner (see NSaligner::traverseGraph)
+ * and moves are chosen in the same order as in SWGAaligner, so the alignments
+ * are those SWGAaligner finds with equal open and extension penalties.
+ */
+class SWaligner: public IAligner
+{
+public:
+  /**
+   * @param[in]  The target sequence
+   * @param[in]  The query sequence
+   * Note that the targetSeq and querySeq are not copied
+   * The gap extension penalty is not used, gaps cost the gap open penalty per base
+   */
+  SWaligner(const DNAVector& tSeq, const DNAVector& qSeq, const AlignerParams& p = AlignerParams(SW));
+
+  ~SWaligner() {}
+
+  /**
+   * main function to call for performing the alignment.
+   * @return Returns the Alignment object which contains the alignment strings and other data
+   */
+  virtual const AlignmentCola& align();
+  virtual const AlignmentCola& align(int targetStartIdx, int queryStartIdx, int targetStopIdx, int queryStopIdx);
+
+  /**
+   * Score-only pass over the graph keeping the start of the local alignment of every cell
+   * @return Returns the best score and the cells the alignment starts and ends on
+   */
+  virtual AlignmentScore score(int targetStartIdx, int queryStartIdx, int targetStopIdx, int queryStopIdx);
+
+  /** Set the aligner up for other sequences, keeping its buffers (see IAligner::reset) */
+  virtual void reset(const DNAVector& tSeq, const DNAVector& qSeq, const AlignerParams& p);
+
+  /** Returns the alignment object which contains the alignment strings and info **/
+  virtual const AlignmentCola& getAlignment() { return alignment; }
+
+  /** Moves the alignment out of the aligner (see IAligner::takeAlignment) */
+  virtual AlignmentCola takeAlignment() { return alignment.release(); }
+
+  /** Returns the target sequence used for the alignment */
+  virtual const DNAVector& getTargetSeq() { return alignment.getTargetSeq(); }
+
+  /** Returns the query sequence used for the alignment */
+  virtual const DNAVector& getQuerySeq() { return alignment.getQuerySeq(); }
+
+protected:
+  /**
+   * Score the given subsection of the graph, checkpoint its middle column
+   * and recurse on the two halves of the optimal path (see NSaligner::traverseGraph)
+   * @param[in] starting point (row and column), ending point (start and end)
+   * @param[in] findEnd: True in the first run, where the end of the local alignment is not known
+   * @param[in] startScore: The score of the start cell, checkpointed by the previous recursion
+   * @return Returns the number of cells visited per cell of the subsection
+   */
+  double traverseGraph(int startRow, int startCol, int endRow, int endCol,
+       bool findEnd, ColaScore startScore);
+
+  /** Set the start cell of a subsection, all other cells of its start column are unreachable */
+  void initColumn(int startRow, int endRow, ColaScore startScore);
+
+  /**
+   * Visit the cells of the columns after startCol up to endCol, between the
+   * start and end rows, keeping the row of the checkpoint ancestor of each cell.
+   * The middle column is checkpointed and the best scored cell updated.
+   * @param ORIGIN: Keep the cell the local alignment starts on instead (score-only pass)
+   * @param[in] starting point (row and column), ending point (start and end)
+   * @param[in] Index of column that should be checkpointed, TRACK_ORIGIN in the score-only pass
+   * @param[in] Whether the best scored cell is needed (i.e. the end node is not known)
+   * @return Returns the number of cells visited
+   */
+  template<bool ORIGIN>
+  double visitColumns(int startRow, int startCol, int endRow, int endCol,
+       int currCheckpointColIndex, bool findBestNode);
+
+  /** The cells are indexed from row -1, the gap row */
+  int getIndex(int row) const { return row+1; }
+
+  /** The row the band of a column is centered on (see EditGraph::getBandCenter) */
+  int getBandCenter(int col) const { return adaptiveBand? bandCenters[col+1] : col; }
+
+  /** Start the band of the first run from the start column (see EditGraph::startBand) */
+  void startBand(int startRow, int startCol) {
+    if(!adaptiveBand) { return; }
+    bandCenters[startCol+1] = startRow-1;
+    bandCenters[startCol+2] = startRow;
+  }
+
+  /** Center the band of the column after the given one on its best scored cell (see EditGraph::centerNextBand) */
+  void centerNextBand(int col, int start, int end);
+
+  int bandWidth;                     /// The width of the band, covering the whole graph if not banded
+  bool adaptiveBand;                 /// Whether the band follows the best scoring diagonal instead of the main one
+  vector<int>       bandCenters;     /// The band center of each column from -1 in adaptive banding, set by the first run
+  vector<ColaScore> scores;          /// The scores of the latest column, updated in place
+  vector<int>       ancestorRows;    /// The checkpoint ancestor row of each cell, or its origin row
+  vector<int>       originCols;      /// The origin column of each cell, only kept in the score-only pass
+  vector<ColaScore> checkpointScores;/// The scores of the checkpointed column
+  EditGraphNode     bestScoredNode;  /// The cell with the best score, used for tracing local alignment
+  AlignmentCola alignment;           /// Object containing the backtraced alignment
+  AlignerParams params;              /// The generic object which includes the relevant penalties
+};
+
+#endif //_SWALIGNER_H_
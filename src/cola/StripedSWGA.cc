@@ -0,0 +1,44 @@
+#ifndef FORCE_DEBUG
+#define NDEBUG
+#endif
+
+#include "StripedSWGA.h"
+#include "SIMDDispatch.h"
+
+// Sections with fewer rows than this are left to the node by node traversal
+#define STRIPED_MIN_ROWS 16
+
+//=====================================================================
+bool StripedSWGA::isApplicable(const StripedTraversal& trav) const {
+  int nRows = trav.endRow - trav.startRow + 1;
+  if(nRows<STRIPED_MIN_ROWS) { return false; }
+  if(trav.trackOrigin) {
+    // The start columns are kept in 16 bits
+    if(trav.endCol>=SHRT_MAX) { return false; }
+  } else if(trav.checkpointCol<=trav.startCol || trav.checkpointCol>trav.endCol) {
+    // Checkpoint ancestors are not carried over from the start column
+    return false;
+  }
+  // The lazy vertical loop relies on gaps getting more expensive as they are extended
+  if(params.getGapOpenP()>=0 || params.getGapExtP()>=0) { return false; }
+  // Penalties need to fit in 16 bits with enough headroom for saturating on the sentinel
+  if(params.getGapOpenP()<SHRT_MIN/2 || params.getGapExtP()<SHRT_MIN/2 ||
+     params.getMismatchP()<SHRT_MIN/2 || params.getMismatchP()>SHRT_MAX/2) { return false; }
+  // A score can at most go up by one per row from the start cell
+  if(trav.startBest + nRows >= SHRT_MAX) { return false; }
+  return true;
+}
+
+bool StripedSWGA::traverse(const DNAVector& tSeq, const DNAVector& qSeq, StripedTraversal& trav) const {
+  if(!isApplicable(trav)) { return false; }
+  // With affine gaps the lazy vertical loop carries the vertical nodes over more stripe boundaries
+  // the more lanes there are, as it keeps them exact, which outweighs the wider vectors past SSE4.1.
+  // With linear gaps a vertical node only extends the best node above it and the widest kernel is used.
+  bool linearGaps = (params.getGapOpenP()==params.getGapExtP());
+  switch(getSIMDLevel(linearGaps? SIMD_AVX512BW : SIMD_SSE41)) {
+    case SIMD_AVX512BW: return stripedSWGAavx512(tSeq, qSeq, params, trav);
+    case SIMD_AVX2:     return stripedSWGAavx2(tSeq, qSeq, params, trav);
+    case SIMD_SSE41:    return stripedSWGAsse41(tSeq, qSeq, params, trav);
+    default:            return false;
+  }
+}
@@ -0,0 +1,120 @@
+#ifndef _STRIPEDSWGA_H_
+#define _STRIPEDSWGA_H_
+
+#include <climits>
+#include "ryggrad/src/general/DNAVector.h"
+#include "AlignerParams.h"
+
+// Sentinel used for scores that are not reachable, adding penalties to it saturates
+#define STRIPED_NEG_INF SHRT_MIN
+// The number of scores kept for each cell: vertical, horizontal and diagonal (as the SWGA depths)
+#define STRIPED_NUM_DEPTHS 3
+
+//=====================================================================
+/**
+ * A section of the edit graph scored by the striped kernel, with the
+ * results needed by the checkpoint recursion of NSaligner::traverseGraph.
+ * Rows are query positions and columns target positions, as in the EditGraph.
+ * The returned columns are in the striped layout of the kernel and their
+ * rows are relative to the start row, see getIndex. Unreachable nodes are
+ * given the score STRIPED_NEG_INF. Checkpoint ancestor rows are also
+ * relative to the start row. In the score-only pass (trackOrigin) there is no
+ * checkpoint column, the checkpoint ancestor of a node is instead the node
+ * its local alignment starts on: its row (relative) and column (absolute)
+ * in place of the checkpoint ancestor row and depth.
+ */
+struct StripedTraversal
+{
+  /**
+   * @param[in] sRow, sCol: The start cell, which is set from the previous recursion
+   * @param[in] eRow, eCol: The end cell
+   * @param[in] cpCol: The column that is checkpointed
+   * @param[in] findBest: Whether the best scored node has to be found
+   * @param[in] sBest, sHorizontal: The best and horizontal scores of the start cell
+   */
+  StripedTraversal(int sRow, int sCol, int eRow, int eCol, int cpCol, bool findBest,
+                   short sBest, short sHorizontal): startRow(sRow), startCol(sCol),
+    endRow(eRow), endCol(eCol), checkpointCol(cpCol), findBestNode(findBest),
+    startBest(sBest), startHorizontal(sHorizontal), trackOrigin(false), lanes(0), segLen(0),
+    bestScore(0), bestRow(0), bestCol(-1), bestDepth(0), bestCPArow(0), bestCPAdepth(0) {}
+
+  /** Get the index of a row (relative to the start row) in the striped columns */
+  int getIndex(int row) const { return (row%segLen)*lanes + row/segLen; }
+
+  int startRow;          /// The row of the start cell
+  int startCol;          /// The column of the start cell
+  int endRow;            /// The last row visited
+  int endCol;            /// The last column visited
+  int checkpointCol;     /// The column that is checkpointed
+  bool findBestNode;     /// Whether the best scored node is needed
+  short startBest;       /// The best score of the start cell
+  short startHorizontal; /// The horizontal gap score of the start cell
+  bool trackOrigin;      /// Whether the start of the alignments is kept instead of checkpoint ancestors
+
+  int lanes;             /// The number of 16-bit lanes in the vectors of the kernel
+  int segLen;            /// The number of vectors in a striped column
+  vector<short> checkpointScores[STRIPED_NUM_DEPTHS]; /// Node scores of the checkpoint column
+  vector<short> endScores[STRIPED_NUM_DEPTHS];        /// Node scores of the end column
+  vector<short> endCPArows[STRIPED_NUM_DEPTHS];       /// Checkpoint ancestor rows in the end column
+  vector<short> endCPAdepths[STRIPED_NUM_DEPTHS];     /// Checkpoint ancestor depths in the end column
+  int bestScore;         /// The score of the best scored node, if it is needed
+  int bestRow;           /// The best scored node (the first in column, row, depth order)
+  int bestCol;
+  int bestDepth;
+  int bestCPArow;
+  int bestCPAdepth;
+};
+
+//=====================================================================
+/**
+ * Striped Smith-Waterman-Gotoh kernel (after Farrar 2007) for scoring sections
+ * of the edit graph of the SWGA/SW aligners. The query rows are laid out in
+ * stripes over the lanes of 16-bit SIMD vectors, the scores for each target
+ * base are taken from a precomputed query profile and the vertical gaps are
+ * only propagated across stripes lazily. Along with the scores, the kernel
+ * keeps the checkpoint ancestor of every node from the checkpoint column on,
+ * so it gives the same nodes as the SWGAaligner traversal, including the
+ * choice between equally scored nodes.
+ * There is a kernel per instruction set, compiled separately and selected at
+ * runtime for the CPU (see SIMDDispatch.h), without SSE4.1 the sections are
+ * left to the node by node traversal. With affine gaps the wider kernels do
+ * not pay off and only run when forced (see StripedSWGA::traverse).
+ */
+class StripedSWGA
+{
+public:
+  StripedSWGA(const AlignerParams& p): params(p) {}
+
+  ~StripedSWGA() {}
+
+  /**
+   * Returns true if the kernel can be used for the given section and the
+   * parameters, i.e. the scores fit in 16 bits and the section is large
+   * enough for the kernel to pay off.
+   */
+  bool isApplicable(const StripedTraversal& trav) const;
+
+  /**
+   * Score the nodes of the given section.
+   * @param[in]  The target sequence
+   * @param[in]  The query sequence
+   * @param[in,out] The section to score, filled in with the results
+   * @return false if the kernel could not be used, e.g. the best scored node
+   *         is needed but there is no positive score in the section
+   */
+  bool traverse(const DNAVector& tSeq, const DNAVector& qSeq, StripedTraversal& trav) const;
+
+private:
+  AlignerParams params; /// The penalties for mismatches and gaps
+};
+
+//=====================================================================
+// The kernels for each instruction set, returning false if they are unavailable in this build
+bool stripedSWGAsse41(const DNAVector& tSeq, const DNAVector& qSeq,
+                      const AlignerParams& params, StripedTraversal& trav);
+bool stripedSWGAavx2(const DNAVector& tSeq, const DNAVector& qSeq,
+                     const AlignerParams& params, StripedTraversal& trav);
+bool stripedSWGAavx512(const DNAVector& tSeq, const DNAVector& qSeq,
+                       const AlignerParams& params, StripedTraversal& trav);
+
+#endif //_STRIPEDSWGA_H_
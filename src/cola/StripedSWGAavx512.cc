@@ -0,0 +1,18 @@
+#ifndef FORCE_DEBUG
+#define NDEBUG
+#endif
+
+// N.B. This file is compiled with AVX-512BW enabled, the kernel is only called if the CPU supports it
+#include "StripedSWGA.h"
+#include "StripedSWGAkernel.h"
+
+//=====================================================================
+bool stripedSWGAavx512(const DNAVector& tSeq, const DNAVector& qSeq,
+                       const AlignerParams& params, StripedTraversal& trav) {
+#if defined(__AVX512BW__)
+  StripedSWGAkernel<AVX512ops> kernel(tSeq, qSeq, params, trav);
+  return kernel.run();
+#else
+  return false;
+#endif
+}
@@ -0,0 +1,383 @@
+#ifndef _STRIPEDSWGAKERNEL_H_
+#define _STRIPEDSWGAKERNEL_H_
+
+#include <algorithm>
+#include "StripedSWGA.h"
+#include "SIMDops.h"
+
+// N.B. This header should only be included from the translation units of the kernels, see SIMDops.h
+
+//=====================================================================
+/**
+ * Striped scoring of a section of the SWGA edit graph. For each node the
+ * score is that of the SWGAaligner traversal:
+ *   V(i,j)  = max(V(i-1,j) + gapExt, B(i-1,j) + gapOpen)   vertical, depth 0
+ *   Hz(i,j) = max(Hz(i,j-1) + gapExt, B(i,j-1) + gapOpen)  horizontal, depth 1
+ *   D(i,j)  = B(i-1,j-1) + match/mismatch                  diagonal, depth 2
+ * where B is the score of the best node of the cell (the first depth holding
+ * the maximum), negative scores are stored as zero and nodes that cannot be
+ * reached keep the STRIPED_NEG_INF sentinel. The checkpoint ancestor of each
+ * node is carried along from the checkpoint column on, taken from the same
+ * parent as the traversal would: the gap node if extending it scores strictly
+ * higher than opening the gap, otherwise the best node. When tracking the
+ * origins (see StripedTraversal) a node whose parent has no positive score
+ * starts a local alignment and is its own ancestor.
+ */
+template<class V>
+class StripedSWGAkernel
+{
+public:
+  typedef typename V::vec vec;
+
+  StripedSWGAkernel(const DNAVector& t, const DNAVector& q, const AlignerParams& p, StripedTraversal& tr);
+
+  /** Score all the columns of the section, see StripedSWGA::traverse */
+  bool run();
+
+private:
+  // The striped arrays of the kernel: the best and horizontal nodes of the previous column,
+  // the nodes of the current column, and their checkpoint ancestors (row and depth)
+  enum { PREV_B, PREV_HZ, PREV_B_ROW, PREV_B_DEPTH, PREV_HZ_ROW, PREV_HZ_DEPTH,
+         CURR_V, CURR_HZ, CURR_D, CURR_B, CURR_V_ROW, CURR_V_DEPTH, CURR_HZ_ROW, CURR_HZ_DEPTH,
+         CURR_D_ROW, CURR_D_DEPTH, CURR_B_ROW, CURR_B_DEPTH, ROW_INDEX, NUM_ARRAYS };
+
+  /**
+   * Get the query profile for a target base: the diagonal score of every row,
+   * followed by the diagonal score from an unreachable cell on the first row
+   * or column (1 for a match and unreachable otherwise, as in the traversal)
+   */
+  const short* getProfile(char base);
+
+  /** Set negative scores to zero, leaving unreachable nodes as they are */
+  vec clamp(vec v) const { return V::max(v, V::select(V::cmpeq(v, vNegInf), vNegInf, vZero)); }
+
+  /**
+   * Score a column, only keeping the checkpoint ancestors from the checkpoint column on,
+   * or the origins of all the nodes with ORIGIN
+   */
+  template<bool TRACK_CPA, bool ORIGIN> void visitColumn(int col);
+
+  /** Find the first row and depth holding the best score of the current column */
+  void updateBest(int col, int colMax, bool hasCPA);
+
+  const DNAVector&  tSeq;
+  const DNAVector&  qSeq;
+  StripedTraversal& trav;
+  int nRows;                 /// The number of rows in the section
+  int segLen;                /// The number of vectors in a column
+  int colLen;                /// The number of rows in a column including the padding
+  vector<short> arena;       /// Memory of the striped arrays
+  short* arrays[NUM_ARRAYS]; /// The striped arrays, swapped between columns
+  vector<short> profiles;    /// The query profiles of the target bases seen so far
+  int profileIdx[UCHAR_MAX+1];
+  short mismatch;
+  vec vZero, vOne, vTwo, vNegInf, vGapOpen, vGapExt, vFirstLane;
+};
+
+template<class V>
+StripedSWGAkernel<V>::StripedSWGAkernel(const DNAVector& t, const DNAVector& q,
+    const AlignerParams& p, StripedTraversal& tr): tSeq(t), qSeq(q), trav(tr), profiles() {
+  const int lanes = V::LANES;
+  nRows  = trav.endRow - trav.startRow + 1;
+  segLen = (nRows + lanes - 1) / lanes;
+  colLen = segLen * lanes;
+  arena.resize(NUM_ARRAYS*colLen, 0);
+  for(int a=0; a<NUM_ARRAYS; a++) { arrays[a] = &arena[a*colLen]; }
+  for(int c=0; c<=UCHAR_MAX; c++) { profileIdx[c] = -1; }
+  trav.lanes  = lanes;
+  trav.segLen = segLen;
+
+  // Rows past the end of the section are never the row of a checkpoint ancestor or the best node
+  for(int s=0; s<segLen; s++) {
+    for(int k=0; k<lanes; k++) {
+      int row = s + k*segLen;
+      arrays[ROW_INDEX][s*lanes+k] = (row<nRows)? row : SHRT_MAX;
+    }
+  }
+
+  mismatch   = p.getMismatchP();
+  vZero      = V::set1(0);
+  vOne       = V::set1(1);
+  vTwo       = V::set1(2);
+  vNegInf    = V::set1(STRIPED_NEG_INF);
+  vGapOpen   = V::set1(p.getGapOpenP());
+  vGapExt    = V::set1(p.getGapExtP());
+  vFirstLane = V::shiftIn(vZero, -1);
+}
+
+template<class V>
+const short* StripedSWGAkernel<V>::getProfile(char base) {
+  unsigned char b = (unsigned char)base;
+  if(profileIdx[b] == -1) {
+    profileIdx[b] = profiles.size() / (2*colLen);
+    profiles.resize(profiles.size() + 2*colLen);
+    short* p = &profiles[profileIdx[b]*2*colLen];
+    const int lanes = V::LANES;
+    for(int s=0; s<segLen; s++) {
+      for(int k=0; k<lanes; k++) {
+        int row = s + k*segLen;
+        // Rows past the end of the section are never part of an alignment
+        if(row>=nRows) {
+          p[s*lanes+k]        = STRIPED_NEG_INF;
+          p[colLen+s*lanes+k] = STRIPED_NEG_INF;
+        } else {
+          bool match = (qSeq[trav.startRow+row] == base);
+          p[s*lanes+k]        = match? 1 : mismatch;
+          p[colLen+s*lanes+k] = match? 1 : STRIPED_NEG_INF;
+        }
+      }
+    }
+  }
+  return &profiles[profileIdx[b]*2*colLen];
+}
+
+template<class V>
+bool StripedSWGAkernel<V>::run() {
+  // The previous column of the first one is the start column, where only the start cell can be reached
+  for(int a=PREV_B; a<=PREV_HZ_DEPTH; a++) {
+    short init = (a==PREV_B || a==PREV_HZ)? STRIPED_NEG_INF : 0;
+    for(int i=0; i<colLen; i++) { arrays[a][i] = init; }
+  }
+  arrays[PREV_B][0]  = trav.startBest;
+  arrays[PREV_HZ][0] = trav.startHorizontal;
+
+  trav.bestScore = 0;
+  trav.bestCol   = -1;
+  for(int col=trav.startCol+1; col<=trav.endCol; col++) {
+    if(trav.trackOrigin) {
+      visitColumn<true, true>(col);
+    } else if(col<trav.checkpointCol) {
+      visitColumn<false, false>(col);
+    } else {
+      visitColumn<true, false>(col);
+    }
+  }
+  return !trav.findBestNode || trav.bestScore>0;
+}
+
+template<class V>
+template<bool TRACK_CPA, bool ORIGIN>
+void StripedSWGAkernel<V>::visitColumn(int col) {
+  const int lanes       = V::LANES;
+  const int last        = (segLen-1)*lanes;
+  const short* pProfile = getProfile(tSeq[col]);
+  const short* pFromInf = pProfile + colLen;
+  const bool atCheckpoint = !ORIGIN && (col == trav.checkpointCol);
+  const vec vCol        = V::set1(col);
+  // The special case of the diagonal move from outside the graph (first row/column)
+  const bool firstCol = (col == 0);
+  const bool firstRow = (trav.startRow == 0);
+  short** a = arrays;
+
+  // The diagonal of the first segment comes from the last segment shifted by one row,
+  // the row above the section is unreachable
+  vec vDiagB     = V::shiftIn(V::load(a[PREV_B] + last), STRIPED_NEG_INF);
+  vec vDiagRow   = V::shiftIn(V::load(a[PREV_B_ROW] + last), 0);
+  vec vDiagDepth = V::shiftIn(V::load(a[PREV_B_DEPTH] + last), 0);
+  // The node above, carried down the segment
+  vec vV = vNegInf, vB = vNegInf;
+  vec vVRow = vZero, vVDepth = vZero, vBRow = vZero, vBDepth = vZero;
+  vec vMax = vNegInf;
+  for(int s=0; s<segLen; s++) {
+    const int o   = s*lanes;
+    vec vPrevB    = V::load(a[PREV_B] + o);
+    vec vPrevHz   = V::load(a[PREV_HZ] + o);
+    vec vHzExt    = V::adds(vPrevHz, vGapExt);
+    vec vHzOpen   = V::adds(vPrevB, vGapOpen);
+    vec vHz       = clamp(V::max(vHzExt, vHzOpen));
+
+    vec vD = V::select(V::cmpeq(vDiagB, vNegInf), vNegInf, V::adds(vDiagB, V::load(pProfile + o)));
+    if(firstCol) {
+      vD = V::max(vD, V::load(pFromInf + o));
+    } else if(s==0 && firstRow) {
+      vD = V::max(vD, V::select(vFirstLane, V::load(pFromInf), vNegInf));
+    }
+    vD = clamp(vD);
+
+    vec vAboveV = vV, vAboveB = vB;
+    vec vVExt  = V::adds(vV, vGapExt);
+    vec vVOpen = V::adds(vB, vGapOpen);
+    vV = clamp(V::max(vVExt, vVOpen));
+    vB = V::max(V::max(vV, vHz), vD);
+
+    V::store(a[CURR_V] + o, vV);
+    V::store(a[CURR_HZ] + o, vHz);
+    V::store(a[CURR_D] + o, vD);
+    V::store(a[CURR_B] + o, vB);
+    vMax = V::max(vMax, vB);
+
+    if(TRACK_CPA) {
+      vec vIsV  = V::cmpeq(vV, vB);
+      vec vIsHz = V::cmpeq(vHz, vB);
+      vec vHzRow, vHzDepth, vDRow, vDDepth;
+      if(atCheckpoint) {
+        // Nodes on the checkpoint column are their own checkpoint ancestors
+        vec vRow = V::load(a[ROW_INDEX] + o);
+        vVRow  = vRow; vVDepth  = vZero;
+        vHzRow = vRow; vHzDepth = vOne;
+        vDRow  = vRow; vDDepth  = vTwo;
+        vBRow  = vRow;
+        vBDepth = V::select(vIsV, vZero, V::select(vIsHz, vOne, vTwo));
+      } else {
+        vec vFromV = V::cmpgt(vVExt, vVOpen);
+        vVRow    = V::select(vFromV, vVRow, vBRow);
+        vVDepth  = V::select(vFromV, vVDepth, vBDepth);
+        vec vFromHz = V::cmpgt(vHzExt, vHzOpen);
+        vHzRow   = V::select(vFromHz, V::load(a[PREV_HZ_ROW] + o), V::load(a[PREV_B_ROW] + o));
+        vHzDepth = V::select(vFromHz, V::load(a[PREV_HZ_DEPTH] + o), V::load(a[PREV_B_DEPTH] + o));
+        vDRow    = vDiagRow;
+        vDDepth  = vDiagDepth;
+        if(ORIGIN) {
+          // Nodes whose parent has no positive score start a local alignment
+          vec vRow    = V::load(a[ROW_INDEX] + o);
+          vec vStartV = V::cmpgt(vOne, V::select(vFromV, vAboveV, vAboveB));
+          vVRow    = V::select(vStartV, vRow, vVRow);
+          vVDepth  = V::select(vStartV, vCol, vVDepth);
+          vec vStartHz = V::cmpgt(vOne, V::select(vFromHz, vPrevHz, vPrevB));
+          vHzRow   = V::select(vStartHz, vRow, vHzRow);
+          vHzDepth = V::select(vStartHz, vCol, vHzDepth);
+          vec vStartD = V::cmpgt(vOne, vDiagB);
+          vDRow    = V::select(vStartD, vRow, vDRow);
+          vDDepth  = V::select(vStartD, vCol, vDDepth);
+        }
+        vBRow    = V::select(vIsV, vVRow, V::select(vIsHz, vHzRow, vDRow));
+        vBDepth  = V::select(vIsV, vVDepth, V::select(vIsHz, vHzDepth, vDDepth));
+      }
+      V::store(a[CURR_V_ROW] + o, vVRow);
+      V::store(a[CURR_V_DEPTH] + o, vVDepth);
+      V::store(a[CURR_HZ_ROW] + o, vHzRow);
+      V::store(a[CURR_HZ_DEPTH] + o, vHzDepth);
+      V::store(a[CURR_D_ROW] + o, vDRow);
+      V::store(a[CURR_D_DEPTH] + o, vDDepth);
+      V::store(a[CURR_B_ROW] + o, vBRow);
+      V::store(a[CURR_B_DEPTH] + o, vBDepth);
+      vDiagRow   = V::load(a[PREV_B_ROW] + o);
+      vDiagDepth = V::load(a[PREV_B_DEPTH] + o);
+    }
+    vDiagB = vPrevB;
+  }
+
+  // Lazy vertical loop: the first segment of each lane continues from the last segment
+  // of the lane before. Carry the nodes over the stripe boundaries and rescore the
+  // vertical nodes until they are the same as scored before.
+  vV      = V::shiftIn(V::load(a[CURR_V] + last), STRIPED_NEG_INF);
+  vB      = V::shiftIn(V::load(a[CURR_B] + last), STRIPED_NEG_INF);
+  vVRow   = V::shiftIn(V::load(a[CURR_V_ROW] + last), 0);
+  vVDepth = V::shiftIn(V::load(a[CURR_V_DEPTH] + last), 0);
+  vBRow   = V::shiftIn(V::load(a[CURR_B_ROW] + last), 0);
+  vBDepth = V::shiftIn(V::load(a[CURR_B_DEPTH] + last), 0);
+  int s = 0;
+  while(true) {
+    const int o  = s*lanes;
+    vec vVExt    = V::adds(vV, vGapExt);
+    vec vVOpen   = V::adds(vB, vGapOpen);
+    vec vNewV    = clamp(V::max(vVExt, vVOpen));
+    bool changed = !V::allEqual(vNewV, V::load(a[CURR_V] + o));
+    vec vNewVRow = vZero, vNewVDepth = vZero;
+    if(TRACK_CPA) {
+      if(atCheckpoint) {
+        vNewVRow   = V::load(a[ROW_INDEX] + o);
+        vNewVDepth = vZero;
+      } else {
+        vec vFromV = V::cmpgt(vVExt, vVOpen);
+        vNewVRow   = V::select(vFromV, vVRow, vBRow);
+        vNewVDepth = V::select(vFromV, vVDepth, vBDepth);
+        if(ORIGIN) {
+          vec vStartV = V::cmpgt(vOne, V::select(vFromV, vV, vB));
+          vNewVRow   = V::select(vStartV, V::load(a[ROW_INDEX] + o), vNewVRow);
+          vNewVDepth = V::select(vStartV, vCol, vNewVDepth);
+        }
+        changed = changed || !V::allEqual(vNewVRow, V::load(a[CURR_V_ROW] + o))
+                          || !V::allEqual(vNewVDepth, V::load(a[CURR_V_DEPTH] + o));
+      }
+    }
+    if(!changed) { break; }
+
+    vec vHz = V::load(a[CURR_HZ] + o);
+    vec vD  = V::load(a[CURR_D] + o);
+    vV = vNewV;
+    vB = V::max(V::max(vV, vHz), vD);
+    V::store(a[CURR_V] + o, vV);
+    V::store(a[CURR_B] + o, vB);
+    vMax = V::max(vMax, vB);
+    if(TRACK_CPA) {
+      vec vIsV  = V::cmpeq(vV, vB);
+      vec vIsHz = V::cmpeq(vHz, vB);
+      vVRow   = vNewVRow;
+      vVDepth = vNewVDepth;
+      if(atCheckpoint) {
+        vBRow   = vNewVRow;
+        vBDepth = V::select(vIsV, vZero, V::select(vIsHz, vOne, vTwo));
+      } else {
+        vBRow   = V::select(vIsV, vVRow, V::select(vIsHz, V::load(a[CURR_HZ_ROW] + o), V::load(a[CURR_D_ROW] + o)));
+        vBDepth = V::select(vIsV, vVDepth, V::select(vIsHz, V::load(a[CURR_HZ_DEPTH] + o), V::load(a[CURR_D_DEPTH] + o)));
+      }
+      V::store(a[CURR_V_ROW] + o, vVRow);
+      V::store(a[CURR_V_DEPTH] + o, vVDepth);
+      V::store(a[CURR_B_ROW] + o, vBRow);
+      V::store(a[CURR_B_DEPTH] + o, vBDepth);
+    }
+    if(++s == segLen) {
+      s       = 0;
+      vV      = V::shiftIn(vV, STRIPED_NEG_INF);
+      vB      = V::shiftIn(vB, STRIPED_NEG_INF);
+      vVRow   = V::shiftIn(vVRow, 0);
+      vVDepth = V::shiftIn(vVDepth, 0);
+      vBRow   = V::shiftIn(vBRow, 0);
+      vBDepth = V::shiftIn(vBDepth, 0);
+    }
+  }
+
+  if(trav.findBestNode) {
+    int colMax = V::hmax(vMax);
+    if(colMax > trav.bestScore) { updateBest(col, colMax, TRACK_CPA); }
+  }
+  if(atCheckpoint) {
+    trav.checkpointScores[0].assign(a[CURR_V], a[CURR_V] + colLen);
+    trav.checkpointScores[1].assign(a[CURR_HZ], a[CURR_HZ] + colLen);
+    trav.checkpointScores[2].assign(a[CURR_D], a[CURR_D] + colLen);
+  }
+  if(!ORIGIN && col == trav.endCol) {
+    const int scoreArr[STRIPED_NUM_DEPTHS] = {CURR_V, CURR_HZ, CURR_D};
+    const int rowArr[STRIPED_NUM_DEPTHS]   = {CURR_V_ROW, CURR_HZ_ROW, CURR_D_ROW};
+    const int depthArr[STRIPED_NUM_DEPTHS] = {CURR_V_DEPTH, CURR_HZ_DEPTH, CURR_D_DEPTH};
+    for(int d=0; d<STRIPED_NUM_DEPTHS; d++) {
+      trav.endScores[d].assign(a[scoreArr[d]], a[scoreArr[d]] + colLen);
+      trav.endCPArows[d].assign(a[rowArr[d]], a[rowArr[d]] + colLen);
+      trav.endCPAdepths[d].assign(a[depthArr[d]], a[depthArr[d]] + colLen);
+    }
+  }
+  std::swap(a[PREV_B], a[CURR_B]);
+  std::swap(a[PREV_HZ], a[CURR_HZ]);
+  std::swap(a[PREV_B_ROW], a[CURR_B_ROW]);
+  std::swap(a[PREV_B_DEPTH], a[CURR_B_DEPTH]);
+  std::swap(a[PREV_HZ_ROW], a[CURR_HZ_ROW]);
+  std::swap(a[PREV_HZ_DEPTH], a[CURR_HZ_DEPTH]);
+}
+
+template<class V>
+void StripedSWGAkernel<V>::updateBest(int col, int colMax, bool hasCPA) {
+  const int lanes = V::LANES;
+  vec vTarget = V::set1(colMax);
+  vec vMinRow = V::set1(SHRT_MAX);
+  for(int s=0; s<segLen; s++) {
+    vec vIsMax = V::cmpeq(V::load(arrays[CURR_B] + s*lanes), vTarget);
+    vMinRow = V::min(vMinRow, V::select(vIsMax, V::load(arrays[ROW_INDEX] + s*lanes), V::set1(SHRT_MAX)));
+  }
+  int row = V::hmin(vMinRow);
+  int idx = trav.getIndex(row);
+  const int scoreArr[STRIPED_NUM_DEPTHS] = {CURR_V, CURR_HZ, CURR_D};
+  const int rowArr[STRIPED_NUM_DEPTHS]   = {CURR_V_ROW, CURR_HZ_ROW, CURR_D_ROW};
+  const int depthArr[STRIPED_NUM_DEPTHS] = {CURR_V_DEPTH, CURR_HZ_DEPTH, CURR_D_DEPTH};
+  int depth = 0;
+  while(arrays[scoreArr[depth]][idx] != colMax) { depth++; }
+  trav.bestScore    = colMax;
+  trav.bestRow      = row;
+  trav.bestCol      = col;
+  trav.bestDepth    = depth;
+  // Checkpoint ancestors are only set from the checkpoint column on
+  trav.bestCPArow   = hasCPA? arrays[rowArr[depth]][idx] : 0;
+  trav.bestCPAdepth = hasCPA? arrays[depthArr[depth]][idx] : 0;
+}
+
+#endif //_STRIPEDSWGAKERNEL_H_
@@ -0,0 +1,18 @@
+#ifndef FORCE_DEBUG
+#define NDEBUG
+#endif
+
+// N.B. This file is compiled with SSE4.1 enabled, the kernel is only called if the CPU supports it
+#include "StripedSWGA.h"
+#include "StripedSWGAkernel.h"
+
+//=====================================================================
+bool stripedSWGAsse41(const DNAVector& tSeq, const DNAVector& qSeq,
+                      const AlignerParams& params, StripedTraversal& trav) {
+#if defined(__SSE4_1__)
+  StripedSWGAkernel<SSE41ops> kernel(tSeq, qSeq, params, trav);
+  return kernel.run();
+#else
+  return false;
+#endif
+}
@@ -0,0 +1,150 @@
+#ifndef _TRACEBACKMATRIX_H_
+#define _TRACEBACKMATRIX_H_
+
+#include <vector>
+#include "EditGraph.h"
+
+using namespace std;
+
+//=====================================================================
+/**
+ * The parent of every node of a section of the edit graph, kept so that the
+ * optimal path is traced back without visiting the section again (see
+ * NSaligner::traceGraph). While the section is visited the checkpoint ancestor
+ * fields of the visited nodes hold their own coordinates (see setSelf), so the
+ * nodes visited after them take the coordinates of their parent (see TRACK_PARENTS).
+ * Once a cell is visited these are packed into a word per node: the depth of the
+ * parent, whether it is a row up and whether it is a column back, whether the node
+ * has a parent at all, and whether it starts the local alignment, i.e. has no
+ * positive score. A match on the first row or column has no parent as it is scored
+ * from the gap row or column, the reset cells there hold no coordinates.
+ * The cells are kept column by column, each from the first row visited in it.
+ */
+class TracebackMatrix
+{
+public:
+  TracebackMatrix(): startCol(0), numDepths(0), colFirstRows(), colOffsets(),
+    links(), deepOffsets(), deepLinks() {}
+
+  /** The number of bytes kept per cell for the nodes at the base depths, the deeper nodes take more */
+  static double getCellBytes(int numDepths) { return numDepths*sizeof(unsigned int) + sizeof(int); }
+
+  /**
+   * Set the matrix up for another section, keeping the allocated memory
+   * @param[in] sCol: The column the section starts from, its first column is the one after
+   * @param[in] numD: The number of base depths of the edit graph columns
+   */
+  void reset(int sCol, int numD) {
+    startCol  = sCol;
+    numDepths = numD;
+    colFirstRows.clear();
+    colOffsets.clear();
+    links.clear();
+    deepOffsets.clear();
+    deepLinks.clear();
+  }
+
+  /** Reserve room for the given number of cells, so that the matrix is not reallocated while visiting */
+  void reserve(double numCells) {
+    links.reserve((size_t)numCells*numDepths);
+    deepOffsets.reserve((size_t)numCells);
+  }
+
+  /** Make the nodes of a cell hold their own coordinates, e.g. the start cell of the section */
+  static void setSelf(int row, int col, EditGraphColumn& column) {
+    int cell = column.getCellIndex(row);
+    for(int depth=0; depth<column.numDepths; depth++) {
+      setSelf(row, col, depth, column.CPAs[depth*column.numCells + cell]);
+    }
+    vector<EditGraphDeepNode>& deepNodes = column.deepNodes[cell];
+    for(int i=0; i<column.deepCounts[cell]; i++) {
+      setSelf(row, col, deepNodes[i].depth, deepNodes[i].CPA);
+    }
+  }
+
+  /**
+   * Keep the parents of the nodes of a visited cell and make them hold their own coordinates.
+   * The cells are added down each column and column by column.
+   */
+  void addCell(int row, int col, EditGraphColumn& column) {
+    // A column starts on its first cell, a column of the band may have no row in the section
+    while((int)colFirstRows.size()<col-startCol) {
+      colFirstRows.push_back(row);
+      colOffsets.push_back(deepOffsets.size());
+    }
+    deepOffsets.push_back(deepLinks.size());
+    int cell = column.getCellIndex(row);
+    for(int depth=0; depth<numDepths; depth++) {
+      int idx = depth*column.numCells + cell;
+      links.push_back(packLink(row, col, column.scores[idx], column.CPAs[idx]));
+      setSelf(row, col, depth, column.CPAs[idx]);
+    }
+    vector<EditGraphDeepNode>& deepNodes = column.deepNodes[cell];
+    for(int i=0; i<column.deepCounts[cell]; i++) {
+      deepLinks.push_back(TracebackDeepLink(deepNodes[i].depth, packLink(row, col, deepNodes[i].score, deepNodes[i].CPA)));
+      setSelf(row, col, deepNodes[i].depth, deepNodes[i].CPA);
+    }
+  }
+
+  /** The packed parent of a node of the section, which must have been visited */
+  unsigned int getLink(int row, int col, int depth) const {
+    int cell = getCell(row, col);
+    if(depth<numDepths) { return links[cell*numDepths + depth]; }
+    int end = (cell+1<(int)deepOffsets.size())? deepOffsets[cell+1] : deepLinks.size();
+    for(int i=deepOffsets[cell]; i<end; i++) {
+      if(deepLinks[i].depth==depth) { return deepLinks[i].link; }
+    }
+    return 0;
+  }
+
+  static bool isLocalStart(unsigned int link)     { return link&1; }
+  static int  getParentRowStep(unsigned int link) { return (link>>1)&1; }
+  static int  getParentColStep(unsigned int link) { return (link>>2)&1; }
+  static bool hasParent(unsigned int link)        { return (link>>3)&1; }
+  static int  getParentDepth(unsigned int link)   { return link>>4; }
+
+private:
+  /** A node above the base depths along with its packed parent */
+  struct TracebackDeepLink
+  {
+    TracebackDeepLink(int d, unsigned int l): depth(d), link(l) {}
+    int depth;         /// The contiguity depth of the node
+    unsigned int link; /// The packed parent
+  };
+
+  /**
+   * Set the checkpoint ancestor coordinates of a node to its own: the column is kept by the parity
+   * of the depth, which is offset so that the reset coordinates (see EditGraphCPA) are told apart
+   */
+  static void setSelf(int row, int col, int depth, EditGraphCPA& cpa) {
+    cpa.row   = row;
+    cpa.depth = 2*depth + (col&1) + 2;
+  }
+
+  /** Pack the parent of a node from the coordinates the node took from it */
+  static unsigned int packLink(int row, int col, ColaScore score, const EditGraphCPA& parent) {
+    if(score==MINUS_INF) { return 0; } // Not on any path
+    unsigned int isLocalStart = (score<=0);
+    if(parent.depth<2) { return isLocalStart; }
+    unsigned int depth   = (parent.depth-2)/2;
+    unsigned int rowStep = row-parent.row;
+    unsigned int colStep = ((parent.depth&1) != (col&1));
+    return (depth<<4) | (1<<3) | (colStep<<2) | (rowStep<<1) | isLocalStart;
+  }
+
+  /** The index of a cell over the section */
+  int getCell(int row, int col) const {
+    int c = col-startCol-1;
+    return colOffsets[c] + row - colFirstRows[c];
+  }
+
+  int startCol;                /// The column the section starts from
+  int numDepths;               /// The number of base depths, each cell has a packed parent for every one
+  vector<int> colFirstRows;    /// The first row kept of each column of the section
+  vector<int> colOffsets;      /// The index of the first cell kept of each column
+  vector<unsigned int> links;  /// The packed parents of the nodes at the base depths, by cell
+  vector<int> deepOffsets;     /// The index of the first deep link of each cell
+  vector<TracebackDeepLink> deepLinks; /// The packed parents of the nodes above the base depths, by cell
+};
+
+#endif //_TRACEBACKMATRIX_H_
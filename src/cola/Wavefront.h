@@ -0,0 +1,70 @@
+#ifndef _WAVEFRONT_H_
+#define _WAVEFRONT_H_
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include "EditGraph.h"
+
+using namespace std;
+
+// The number of columns a block of rows can get ahead of the block below it
+#define WAVEFRONT_RING_SIZE 64
+// The smallest number of rows given to a thread, smaller sections are visited on a single thread
+#define WAVEFRONT_MIN_ROWS 512
+// The smallest number of columns worth starting the threads for
+#define WAVEFRONT_MIN_COLS 256
+
+//=====================================================================
+/**
+ * State shared by the threads of a wavefront traversal. The rows of the
+ * section are split into blocks, one per thread, and each block is visited
+ * column by column once the block above it has visited the column: the
+ * tiles (a block of rows of one column) on an anti-diagonal are computed
+ * at the same time. The last cell of each block is passed down to the block
+ * below through a ring of the latest columns, a block waits if the ring is full.
+ */
+class WavefrontState
+{
+public:
+  /**
+   * @param[in] startRow, endRow: The rows of the section
+   * @param[in] startCol: The column the section starts from (already set)
+   * @param[in] numBlocks: The number of blocks/threads
+   * @param[in] maxCD: The maximum contiguity depth
+   */
+  WavefrontState(int startRow, int endRow, int startCol, int numBlocks, int maxCD)
+    :firstRows(numBlocks+1), progress(numBlocks),
+     boundaries(numBlocks, vector<EditGraphDepth>(WAVEFRONT_RING_SIZE, EditGraphDepth(maxCD))) {
+    int numRows = endRow-startRow+1;
+    for(int b=0; b<=numBlocks; b++) { firstRows[b] = startRow + (long long)numRows*b/numBlocks; }
+    for(int b=0; b<numBlocks; b++)  { progress[b].store(startCol); }
+  }
+
+  int getNumBlocks() const           { return progress.size(); }
+  int getFirstRow(int block) const   { return firstRows[block]; }
+  int getLastRow(int block) const    { return firstRows[block+1]-1; }
+
+  /** The last cell of the block at the given column, written by the block and read by the one below */
+  EditGraphDepth& getBoundary(int block, int col) { return boundaries[block][col%WAVEFRONT_RING_SIZE]; }
+
+  /** Wait until the block has visited the given column */
+  void waitForColumn(int block, int col) const {
+    while(progress[block].load(memory_order_acquire)<col) { this_thread::yield(); }
+  }
+
+  /** Wait until the boundary of the given column can be written, i.e. the block below is done with its slot */
+  void waitForRing(int block, int col) const {
+    if(block+1<getNumBlocks()) { waitForColumn(block+1, col-WAVEFRONT_RING_SIZE); }
+  }
+
+  /** Mark the column as visited by the block, publishing its boundary cell */
+  void setColumnDone(int block, int col) { progress[block].store(col, memory_order_release); }
+
+private:
+  vector<int> firstRows;                    /// The first row of each block, followed by the row after the section
+  vector< atomic<int> > progress;           /// The latest column visited by each block
+  vector< vector<EditGraphDepth> > boundaries; /// Ring of the last cells of each block, indexed by column
+};
+
+#endif //_WAVEFRONT_H_
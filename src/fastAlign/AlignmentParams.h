@@ -8,19 +8,21 @@ public:
                     float minIdent=0.7, int alignmentBound=3, float minSeedCover=0.25)
                    :m_suffixStep(stepSize), m_seedSize(seedSize),
                     m_minIdent(minIdent), m_alignmentBound(alignmentBound), 
-                    m_minSeedCover(minSeedCover)  { }
+                    m_minSeedCover(minSeedCover), m_xDrop(100)  { }
 
     int   getSuffixStep() const     { return m_suffixStep;     }  
     int   getSeedSize()  const      { return m_seedSize;       } 
     float getMinIdentity() const    { return m_minIdent;       }
     int   getAlignBand() const      { return m_alignmentBound; }
     float getMinSeedCover() const   { return m_minSeedCover;   }
+    int   getXDrop() const          { return m_xDrop;          }
 
     void  setSuffixStep(int sst)    { m_suffixStep     = sst;  }  
     void  setSeedSize(int ss)       { m_seedSize       = ss;   } 
     void  setMinIdentity(float idt) { m_minIdent       = idt;  }
     void  setAlignBand(int ab)      { m_alignmentBound = ab;   }
     void  setMinSeedCover(float sc) { m_minSeedCover   = sc;   }
+    void  setXDrop(int xd)          { m_xDrop          = xd;   }
 
 
 private: 
@@ -29,6 +31,7 @@ private:
     float   m_minIdent;       /// Minimum identity for accepting a candidate read as an assembly extension
     int     m_alignmentBound; /// Alignment bandwidth used for local alignment to decide on choosing candidate reads
     float   m_minSeedCover;   /// The minimum acceptance level of seed coverage for choosing alignment candidates 
+    int     m_xDrop;          /// The score drop from the best cell past which local alignments are not extended, -1 to align to the sequence ends
 };
 //======================================================
 
@@ -8,6 +8,7 @@
 #include "SeedingThreads.h"
 #include "AlignmentThreads.h"
 #include "FastAlignUnit.h"
+#include "MatchLength.h"
 
 //======================================================
 
@@ -93,6 +94,8 @@ void FastAlignUnit::alignSequence(int querySeqIdx, svec<AlignmentInfo>& cAlignme
     if(storeAlignmentInfo) {
       cAlignmentInfos.reserve(candidSynts.isize());
     }
+    // The aligners are reused between the candidates of the query
+    ColaWorkspace workspace;
     for(int i=0; i<candidSynts.isize(); i++) {
         FILE_LOG(logDEBUG3) << " Aligning based on candidate syntenic seed set: " << candidSynts[i].toString();
         FILE_LOG(logDEBUG3) << "Indel size: " << candidSynts[i].getMaxCumIndelSize() << "  Seed Count: " 
@@ -116,13 +119,26 @@ void FastAlignUnit::alignSequence(int querySeqIdx, svec<AlignmentInfo>& cAlignme
                             << " and inital query offset: " << candidSynts[i].getInitQueryOffset() 
                             << " initial target offset: " << candidSynts[i].getInitTargetOffset();
         if(colaIndent>m_params.getAlignBand()) { colaIndent = m_params.getAlignBand(); }
-        cola1.createAlignment(target, query, AlignerParams(colaIndent, SWGA));
+        // The sequences are aligned from the seeds to their ends, the alignment is not
+        // extended once its score drops too far below the best one found. The band follows
+        // the alignment, so it only needs to cover single indels rather than their drift.
+        // The alignment is usually a small part of the sequences, so it is only traced
+        // within the extent a score-only pass finds for it.
+        AlignerParams colaParams(colaIndent, SWGA);
+        colaParams.setXDrop(m_params.getXDrop());
+        colaParams.setAdaptiveBand(true);
+        colaParams.setLocalized(true);
+        const AlignmentCola* algn;
         if(storeAlignmentInfo) {
-          cAlignmentInfos.push_back(cola1.getAlignment().getInfo());
+          algn = &cola1.createAlignment(workspace, target, query, colaParams);
+          cAlignmentInfos.push_back(algn->getInfo());
           cAlignmentInfos.back().setSeqAuxInfo(targetOffset, queryOffset, true, true); //TODO pass in the strand from function calling alignSequence
+        } else {
+          // Alignments are only printed if identical enough, so only those that can be are traced
+          algn = &cola1.createAlignment(workspace, target, query, colaParams, 1.0, m_params.getMinIdentity());
         }
-        if(printResults) {
-          Alignment& tempAlgn = cola1.getAlignment();
+        if(printResults && algn->getLength()>0) {
+          Alignment tempAlgn = algn->getExpanded();
           tempAlgn.setSeqAuxInfo(targetOffset, queryOffset, true, true); 
           writeAlignment(tempAlgn, sOut, mtx);
         }
@@ -228,12 +244,7 @@ int FastAlignTargetUnit::checkInitMatch(const DNAVector& querySeq, int queryOffs
     const DNAVector& d2 = m_suffixes.getString(idx2);
 
     int limit = min(querySeq.isize()-queryOffset, m_suffixes.getStringSize(idx2)-offset2);
-    int seedSize=0;
-    for(; seedSize<limit; seedSize++) {
-        if(querySeq[queryOffset+seedSize]!=d2[offset2+seedSize]) {
-            break;
-        }
-    }
-    return seedSize;
+    if(limit<=0) { return 0; }
+    return getMatchLength(&querySeq[queryOffset], &d2[offset2], limit);
 }
 //======================================================
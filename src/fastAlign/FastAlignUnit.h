@@ -14,8 +14,8 @@
 class FastAlignTargetUnit
 {
 public:
-    FastAlignTargetUnit(const string& inputFile, int stepSize): m_targetSeqs(inputFile), 
-                                                               m_suffixes(m_targetSeqs, stepSize) {}
+    FastAlignTargetUnit(const string& inputFile, int stepSize, int numThreads=1): m_targetSeqs(inputFile), 
+                                                               m_suffixes(m_targetSeqs, stepSize, numThreads) {}
 
     const DNAVector&  getTargetSeq(int seqIdx) const { return m_targetSeqs[seqIdx];        }
     int getTargetSeqSize(int seqIdx) const           { return m_targetSeqs[seqIdx].size(); }
@@ -0,0 +1,30 @@
+#ifndef FORCE_DEBUG
+#define NDEBUG
+#endif
+
+#include "MatchLength.h"
+#include "../cola/SIMDDispatch.h"
+
+//======================================================
+typedef int (*MatchLengthFunc)(const char* s1, const char* s2, int limit);
+
+static MatchLengthFunc selectMatchLength() {
+    switch(getSIMDLevel()) {
+        case SIMD_AVX512BW: return getMatchLengthAVX512;
+        case SIMD_AVX2:     return getMatchLengthAVX2;
+        case SIMD_SSE41:    return getMatchLengthSSE41;
+        default:            return getMatchLengthScalar;
+    }
+}
+
+int getMatchLength(const char* s1, const char* s2, int limit) {
+    static const MatchLengthFunc matchLength = selectMatchLength();
+    return matchLength(s1, s2, limit);
+}
+
+int getMatchLengthScalar(const char* s1, const char* s2, int limit) {
+    int i = 0;
+    while(i<limit && s1[i]==s2[i]) { i++; }
+    return i;
+}
+//======================================================
@@ -0,0 +1,18 @@
+#ifndef _MATCH_LENGTH_H_
+#define _MATCH_LENGTH_H_
+
+//======================================================
+/** Returns the number of leading bases two sequences have in common, up to the given limit
+    (both need to hold at least limit bases). The bases are compared a vector at a time with
+    the instruction set chosen for the CPU (see ../cola/SIMDDispatch.h) */
+int getMatchLength(const char* s1, const char* s2, int limit);
+
+// The variants for each instruction set, each compiled with its own target flags.
+// The vector ones fall back to the scalar one if they are unavailable in this build.
+int getMatchLengthScalar(const char* s1, const char* s2, int limit);
+int getMatchLengthSSE41(const char* s1, const char* s2, int limit);
+int getMatchLengthAVX2(const char* s1, const char* s2, int limit);
+int getMatchLengthAVX512(const char* s1, const char* s2, int limit);
+//======================================================
+
+#endif //_MATCH_LENGTH_H_
@@ -0,0 +1,33 @@
+#ifndef FORCE_DEBUG
+#define NDEBUG
+#endif
+
+// N.B. This file is compiled with AVX2 enabled, it is only called if the CPU supports it
+#include "MatchLength.h"
+#if defined(__AVX2__)
+  #include <immintrin.h>
+#endif
+
+//======================================================
+int getMatchLengthAVX2(const char* s1, const char* s2, int limit) {
+#if defined(__AVX2__)
+    int i = 0;
+    for(; i+32<=limit; i+=32) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(s1+i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(s2+i));
+        unsigned int mismatches = ~(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
+        if(mismatches) { return i + __builtin_ctz(mismatches); }
+    }
+    if(i+16<=limit) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(s1+i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(s2+i));
+        int mismatches = _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) ^ 0xFFFF;
+        if(mismatches) { return i + __builtin_ctz(mismatches); }
+        i += 16;
+    }
+    return i + getMatchLengthScalar(s1+i, s2+i, limit-i);
+#else
+    return getMatchLengthScalar(s1, s2, limit);
+#endif
+}
+//======================================================
@@ -0,0 +1,28 @@
+#ifndef FORCE_DEBUG
+#define NDEBUG
+#endif
+
+// N.B. This file is compiled with AVX-512BW enabled, it is only called if the CPU supports it
+#include "MatchLength.h"
+#if defined(__AVX512BW__)
+  #include <immintrin.h>
+#endif
+
+//======================================================
+int getMatchLengthAVX512(const char* s1, const char* s2, int limit) {
+#if defined(__AVX512BW__)
+    for(int i=0; i<limit; i+=64) {
+        // The bases past the limit are masked out of the loads, so they are never read
+        int n = limit-i;
+        __mmask64 inside = (n>=64)? ~0ULL : (1ULL<<n)-1;
+        __m512i a = _mm512_maskz_loadu_epi8(inside, s1+i);
+        __m512i b = _mm512_maskz_loadu_epi8(inside, s2+i);
+        unsigned long long mismatches = _mm512_mask_cmpneq_epi8_mask(inside, a, b);
+        if(mismatches) { return i + __builtin_ctzll(mismatches); }
+    }
+    return limit>0? limit : 0;
+#else
+    return getMatchLengthScalar(s1, s2, limit);
+#endif
+}
+//======================================================
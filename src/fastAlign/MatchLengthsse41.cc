@@ -0,0 +1,26 @@
+#ifndef FORCE_DEBUG
+#define NDEBUG
+#endif
+
+// N.B. This file is compiled with SSE4.1 enabled, it is only called if the CPU supports it
+#include "MatchLength.h"
+#if defined(__SSE4_1__)
+  #include <smmintrin.h>
+#endif
+
+//======================================================
+int getMatchLengthSSE41(const char* s1, const char* s2, int limit) {
+#if defined(__SSE4_1__)
+    int i = 0;
+    for(; i+16<=limit; i+=16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(s1+i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(s2+i));
+        int mismatches = _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) ^ 0xFFFF;
+        if(mismatches) { return i + __builtin_ctz(mismatches); }
+    }
+    return i + getMatchLengthScalar(s1+i, s2+i, limit-i);
+#else
+    return getMatchLengthScalar(s1, s2, limit);
+#endif
+}
+//======================================================
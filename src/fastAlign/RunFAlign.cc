@@ -18,7 +18,8 @@ int main(int argc,char** argv)
     commandArg<int>    cCmmd("-b","Subread block step", 2);
     commandArg<int>    dCmmd("-S","Seed size for choosing candidates", 20);
     commandArg<double> eCmmd("-I","Minimum acceptable identity for seeding sequences", 0.4);
-    commandArg<int>    fCmmd("-B","Bandwidth for local alignments", 50);
+    commandArg<int>    fCmmd("-B","Bandwidth for local alignments, the band follows the alignment", 32);
+    commandArg<int>    xDropCmmd("-X","X-drop for local alignments, -1 to align to the end of the sequences", 100);
     commandArg<string> gCmmd("-L","Application logging file","application.log");
     commandArg<int>    threadCmmd("-T","Number of Cores to run with", 1);
 
@@ -32,6 +33,7 @@ int main(int argc,char** argv)
     P.registerArg(dCmmd);
     P.registerArg(eCmmd);
     P.registerArg(fCmmd);
+    P.registerArg(xDropCmmd);
     P.registerArg(gCmmd);
     P.registerArg(threadCmmd);
     P.parse();
@@ -43,6 +45,7 @@ int main(int argc,char** argv)
     int    seedSize        = P.GetIntValueFor(dCmmd);
     double minIdent        = P.GetDoubleValueFor(eCmmd);
     int    alignBand       = P.GetIntValueFor(fCmmd);
+    int    xDrop           = P.GetIntValueFor(xDropCmmd);
     string applicationFile = P.GetStringValueFor(gCmmd);
     int    numThreads      = P.GetIntValueFor(threadCmmd);
     
@@ -59,7 +62,8 @@ int main(int argc,char** argv)
 
     AlignmentParams params(readBlockSize, seedSize,
                            minIdent, alignBand, 0.05); // TODO The seed coverage threshold needs to be looked into
-    FastAlignTargetUnit qUnit(targetSeqFile, readBlockSize);
+    params.setXDrop(xDrop);
+    FastAlignTargetUnit qUnit(targetSeqFile, readBlockSize, numThreads);
 
     FastAlignUnit FAUnit(querySeqFile, qUnit, params, numThreads);
     FAUnit.alignAllSeqs(numThreads, fOut);
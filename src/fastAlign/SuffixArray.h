@@ -1,11 +1,7 @@
 #ifndef _SUFFIX_ARRAY_H
 #define _SUFFIX_ARRAY_H
 
-#if defined(OPEN_MP)
-  #include <parallel/algorithm>
-#else
-  #include <algorithm>
-#endif
+#include <algorithm>
 
 
 #include <map>
@@ -18,7 +14,9 @@
 #include "ryggrad/src/base/Logger.h"
 #include "../cola/Cola.h"
 #include "AlignmentParams.h"
+#include "MatchLength.h"
 #include "SeedingObjects.h"
+#include "SuffixSorter.h"
 #include "DNASeqs.h"
 
 
@@ -78,8 +76,8 @@ template<class StringContainerType, class StringType>
 class SuffixArray {
 public:
     // Ctor1:
-    SuffixArray(const StringContainerType& strings, int stepSize): m_suffixes(), m_strings(strings),
-                m_stepSize_p(stepSize) { 
+    SuffixArray(const StringContainerType& strings, int stepSize, int numThreads=1): m_suffixes(), m_strings(strings),
+                m_stepSize_p(stepSize), m_numThreads(numThreads) { 
       constructSuffixes(); 
     }
 
@@ -131,6 +129,7 @@ private:
     svec<SuffixArrayElement>      m_suffixes;     /// Vector of suffixes 
     const StringContainerType&    m_strings;      /// Reference to the list of strings from which suffixes where constructed
     int                           m_stepSize_p;   /// Parameter specifing the size of steps for constructing suffixes 
+    int                           m_numThreads;   /// Number of threads to sort the suffixes with
 };
 //======================================================
 
@@ -228,12 +227,37 @@ template<class StringContainerType, class StringType>
 void SuffixArray<StringContainerType, StringType>::sortSuffixes() {
     FILE_LOG(logINFO) << "Starting to sort SuffixArray";
     cout << "Starting to sort SuffixArray" << endl;
-    // Could not do this in header by including namespaces as std has been declared in a parent header.
-    #if defined(OPEN_MP)
-        __gnu_parallel::stable_sort(m_suffixes.begin(), m_suffixes.end(), CmpSuffixArrayElement(*this));
-    #else
+    // The sorter takes the suffixes at every step-th offset of each string in string then offset order,
+    // as constructSuffixes makes them, and gives the same order as a stable sort on compareBases
+    std::vector<const char*> strings(m_strings.getNumSeqs(), NULL);
+    std::vector<int>         lengths(m_strings.getNumSeqs(), 0);
+    long numSampled = 0;
+    for(int i=0; i<m_strings.getNumSeqs(); i++) {
+        lengths[i] = getStringSize(i);
+        if(lengths[i]>0) { strings[i] = &m_strings[i][0]; }
+        numSampled += (lengths[i]+getSuffixStep()-1)/getSuffixStep();
+    }
+    if(numSampled!=(long)m_suffixes.size()) { // Some suffixes have been filtered out
         std::stable_sort(m_suffixes.begin(), m_suffixes.end(), CmpSuffixArrayElement(*this));
-    #endif
+    } else {
+        std::vector<int> order;
+        SuffixSorter sorter(getSuffixStep(), m_numThreads);
+        sorter.sort(strings, lengths, order);
+        // Move each suffix to its sorted position in place, one cycle of the permutation at a time
+        for(int p=0; p<(int)order.size(); p++) {
+            if(order[p]<0) { continue; } // Already in place
+            SuffixArrayElement first = m_suffixes[p];
+            int q = p;
+            while(order[q]!=p) {
+                int from      = order[q];
+                m_suffixes[q] = m_suffixes[from];
+                order[q]      = -1;
+                q             = from;
+            }
+            m_suffixes[q] = first;
+            order[q]      = -1;
+        }
+    }
     FILE_LOG(logINFO) << "Finished sorting SuffixArray";
     cout << "Finished sorting suffixes" << endl;
 }
@@ -254,12 +278,9 @@ int SuffixArray<StringContainerType, StringType>::compareBases(const SuffixArray
     const StringType& d1 = getString(idx1);
     const StringType& d2 = getString(idx2); 
 
-    for(int i=0; i<limit; i++) {
-        if(d1[offset1+i]<d2[offset2+i]) {
-            return -1; //Smaller
-        } else if(d1[offset1+i]>d2[offset2+i]) {
-            return 1;  //Larger
-        }
+    int i = (limit>0)? getMatchLength(&d1[offset1], &d2[offset2], limit) : 0;
+    if(i<limit) { 
+        return (d1[offset1+i]<d2[offset2+i])? -1 : 1; //Smaller or larger
     }
     if(size1 < size2)      { return -1; }
     else if(size1 > size2) { return 1;  }
@@ -282,12 +303,9 @@ int SuffixArray<StringContainerType, StringType>::compareBases(const SuffixArray
     int limit = min(size1, size2);
 
     const StringType& d1 = getString(idx1);
-    for(int i=0; i<limit; i++) {
-        if(d1[offset1+i]<d2[offset2+i]) {
-            return -1; //Smaller
-        } else if(d1[offset1+i]>d2[offset2+i]) {
-            return 1;  //Larger
-        }
+    int i = (limit>0)? getMatchLength(&d1[offset1], &d2[offset2], limit) : 0;
+    if(i<limit) { 
+        return (d1[offset1+i]<d2[offset2+i])? -1 : 1; //Smaller or larger
     }
     if(size1 < size2)      { return -1; }
     else if(size1 > size2) { return 1;  }
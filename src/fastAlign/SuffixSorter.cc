@@ -0,0 +1,256 @@
+#ifndef FORCE_DEBUG
+#define NDEBUG
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "SuffixSorter.h"
+
+//======================================================
+void SuffixSorter::sort(const std::vector<const char*>& strings, const std::vector<int>& lengths, std::vector<int>& order) {
+    m_strings = &strings;
+    m_lengths = &lengths;
+    m_firstIds.resize(lengths.size()+1);
+    m_firstIds[0] = 0;
+    for(size_t i=0; i<lengths.size(); i++) {
+        m_firstIds[i+1] = m_firstIds[i] + (lengths[i]+m_step-1)/m_step;
+    }
+    order.resize(m_firstIds.back());
+    if(order.empty()) { return; }
+
+    setAlphabet();
+    m_ranks.resize(order.size());
+    sortPrefixes(order);
+    refineGroups(order);
+    std::vector<int>().swap(m_ranks);
+    std::vector<std::pair<int,int> >().swap(m_groups);
+}
+
+template<class FuncType>
+void SuffixSorter::runThreads(FuncType func) const {
+    std::vector<std::thread> threads;
+    for(int t=1; t<m_numThreads; t++) {
+        threads.push_back(std::thread(func, t));
+    }
+    func(0);
+    for(size_t t=0; t<threads.size(); t++) {
+        threads[t].join();
+    }
+}
+
+int SuffixSorter::getStringIdx(int id) const {
+    return std::upper_bound(m_firstIds.begin(), m_firstIds.end(), id) - m_firstIds.begin() - 1;
+}
+
+uint64_t SuffixSorter::packBases(int strIdx, int offset, int numBases) const {
+    const char* bases = (*m_strings)[strIdx];
+    int end  = std::min(numBases, (*m_lengths)[strIdx]-offset);
+    uint64_t word = 0;
+    for(int i=0; i<end; i++) {
+        word = (word<<m_bits) | m_baseRanks[(unsigned char)bases[offset+i]];
+    }
+    return (end>0? word<<(64-m_bits*end): 0);
+}
+
+void SuffixSorter::setAlphabet() {
+    // Find the bases that occur, then rank them in the order chars compare in
+    int numStrings = m_lengths->size();
+    std::vector<std::vector<char> > seen(m_numThreads, std::vector<char>(UCHAR_MAX+1, 0));
+    std::atomic<int> nextString(0);
+    runThreads([&](int t) {
+        for(int i=nextString++; i<numStrings; i=nextString++) {
+            const char* bases = (*m_strings)[i];
+            for(int j=0; j<(*m_lengths)[i]; j++) {
+                seen[t][(unsigned char)bases[j]] = 1;
+            }
+        }
+    });
+    std::vector<char> alphabet;
+    for(int c=0; c<=UCHAR_MAX; c++) {
+        for(int t=0; t<m_numThreads; t++) {
+            if(seen[t][c]) { alphabet.push_back((char)c); break; }
+        }
+    }
+    std::sort(alphabet.begin(), alphabet.end());
+    std::fill(m_baseRanks, m_baseRanks+UCHAR_MAX+1, 0);
+    for(size_t r=0; r<alphabet.size(); r++) {
+        m_baseRanks[(unsigned char)alphabet[r]] = r+1;
+    }
+
+    m_bits = 1;
+    while((1u<<m_bits) <= alphabet.size()) { m_bits++; }
+    m_basesPerWord = 64/m_bits;
+    m_prefixLen    = (m_step<=m_basesPerWord)? m_basesPerWord/m_step*m_step: m_step;
+    m_numWords     = (m_prefixLen+m_basesPerWord-1)/m_basesPerWord;
+}
+
+void SuffixSorter::sortPrefixes(std::vector<int>& order) {
+    // Bucket the suffixes by the top 16 bits of their packed prefix, keeping them in id order within buckets.
+    // The first word of the prefix is packed as the strings are read in order and moved along with the id.
+    const int numBuckets  = 1<<16;
+    const int digitBases  = std::min(m_prefixLen, (16+m_bits-1)/m_bits);
+    const int firstBases  = std::min(m_prefixLen, m_basesPerWord);
+    const int numSuffixes = order.size();
+    std::vector<std::vector<int> > counts(m_numThreads, std::vector<int>(numBuckets, 0));
+    std::vector<uint64_t> firstWords;
+    auto forEachSuffix = [&](int t, int bucketPass) {
+        int begin = (int64_t)numSuffixes*t/m_numThreads;
+        int end   = (int64_t)numSuffixes*(t+1)/m_numThreads;
+        int strIdx = (begin<end)? getStringIdx(begin): 0;
+        for(int id=begin; id<end; id++) {
+            while(id>=m_firstIds[strIdx+1]) { strIdx++; }
+            int offset = (id-m_firstIds[strIdx])*m_step;
+            if(bucketPass) {
+                uint64_t word = packBases(strIdx, offset, firstBases);
+                int      pos  = counts[t][word>>48]++;
+                order[pos]      = id;
+                firstWords[pos] = word;
+            } else {
+                counts[t][packBases(strIdx, offset, digitBases)>>48]++;
+            }
+        }
+    };
+    runThreads([&](int t) { forEachSuffix(t, 0); });
+    std::vector<int> bucketStarts(numBuckets+1, 0);
+    int pos = 0;
+    for(int b=0; b<numBuckets; b++) {
+        bucketStarts[b] = pos;
+        for(int t=0; t<m_numThreads; t++) {
+            int count    = counts[t][b];
+            counts[t][b] = pos;
+            pos         += count;
+        }
+    }
+    bucketStarts[numBuckets] = pos;
+    firstWords.resize(numSuffixes);
+    runThreads([&](int t) { forEachSuffix(t, 1); });
+    std::vector<std::vector<int> >().swap(counts);
+
+    // Sort each bucket on the whole prefix and rank the suffixes by the first one sharing their prefix
+    std::vector<std::vector<std::pair<int,int> > > groups(m_numThreads);
+    std::atomic<int> nextBucket(0);
+    runThreads([&](int t) {
+        std::vector<uint64_t> words;
+        std::vector<int>      ids;
+        std::vector<std::pair<uint64_t,int> > perm;
+        for(int b=nextBucket++; b<numBuckets; b=nextBucket++) {
+            int start = bucketStarts[b];
+            int size  = bucketStarts[b+1]-start;
+            if(size==1) { m_ranks[order[start]] = start; }
+            if(size<=1) { continue; }
+            words.resize((size_t)size*m_numWords);
+            ids.assign(order.begin()+start, order.begin()+start+size);
+            perm.resize(size);
+            for(int k=0; k<size; k++) {
+                words[(size_t)k*m_numWords] = firstWords[start+k];
+                if(m_numWords>1) {
+                    int strIdx = getStringIdx(ids[k]);
+                    int offset = (ids[k]-m_firstIds[strIdx])*m_step;
+                    for(int w=1; w<m_numWords; w++) {
+                        int wordBases = std::min(m_basesPerWord, m_prefixLen-w*m_basesPerWord);
+                        words[(size_t)k*m_numWords+w] = packBases(strIdx, offset+w*m_basesPerWord, wordBases);
+                    }
+                }
+                perm[k] = std::make_pair(firstWords[start+k], k);
+            }
+            // Ids are ascending in the bucket, so ties on the prefix are kept in id order by the position.
+            // Sort on the first word, then on the others where it ties.
+            auto cmpWords = [&](int a, int b) {
+                for(int w=0; w<m_numWords; w++) {
+                    uint64_t wa = words[(size_t)a*m_numWords+w];
+                    uint64_t wb = words[(size_t)b*m_numWords+w];
+                    if(wa!=wb) { return (wa<wb)? -1: 1; }
+                }
+                return 0;
+            };
+            std::sort(perm.begin(), perm.end());
+            for(int k=0, tieEnd=0; m_numWords>1 && k<size; k=tieEnd) {
+                for(tieEnd=k+1; tieEnd<size && perm[tieEnd].first==perm[k].first; tieEnd++) {}
+                std::sort(perm.begin()+k, perm.begin()+tieEnd, [&](const std::pair<uint64_t,int>& a, const std::pair<uint64_t,int>& b) {
+                    int cmp = cmpWords(a.second, b.second);
+                    return (cmp!=0)? cmp<0: a.second<b.second;
+                });
+            }
+            for(int k=0, groupStart=0; k<size; k++) {
+                if(k>0 && cmpWords(perm[k-1].second, perm[k].second)!=0) {
+                    if(k-groupStart>1) { groups[t].push_back(std::make_pair(start+groupStart, k-groupStart)); }
+                    groupStart = k;
+                }
+                order[start+k]              = ids[perm[k].second];
+                m_ranks[ids[perm[k].second]] = start+groupStart;
+                if(k==size-1 && size-groupStart>1) { groups[t].push_back(std::make_pair(start+groupStart, size-groupStart)); }
+            }
+        }
+    });
+    std::vector<uint64_t>().swap(firstWords);
+    m_groups.clear();
+    for(int t=0; t<m_numThreads; t++) {
+        m_groups.insert(m_groups.end(), groups[t].begin(), groups[t].end());
+    }
+}
+
+void SuffixSorter::refineGroups(std::vector<int>& order) {
+    // A group of suffixes sharing their first h bases is sorted on the rank of the suffixes h bases on,
+    // which sorts them on 2h bases. Those without one end within h bases and come first, and if the
+    // whole group does they are equal and stay in id order.
+    int64_t idStep = m_prefixLen/m_step; // The difference in id between a suffix and the one h bases on
+    std::vector<uint64_t> keys;
+    std::vector<size_t>   keyStarts;
+    while(!m_groups.empty()) {
+        int numGroups = m_groups.size();
+        keyStarts.resize(numGroups+1);
+        keyStarts[0] = 0;
+        for(int g=0; g<numGroups; g++) {
+            keyStarts[g+1] = keyStarts[g] + m_groups[g].second;
+        }
+        keys.resize(keyStarts[numGroups]);
+        int chunk = std::max(1, numGroups/(m_numThreads*64));
+
+        // Ranks are only read in this pass and only written in the next, so all keys come from the previous round
+        std::atomic<int> nextGroup(0);
+        runThreads([&](int t) {
+            for(int first=nextGroup.fetch_add(chunk); first<numGroups; first=nextGroup.fetch_add(chunk)) {
+                for(int g=first; g<std::min(first+chunk, numGroups); g++) {
+                    for(int k=0; k<m_groups[g].second; k++) {
+                        int     id   = order[m_groups[g].first+k];
+                        int64_t next = id+idStep;
+                        int     rank = (next<m_firstIds[getStringIdx(id)+1])? m_ranks[next]: -1;
+                        keys[keyStarts[g]+k] = ((uint64_t)(rank+1)<<32) | (uint32_t)id;
+                    }
+                }
+            }
+        });
+
+        std::vector<std::vector<std::pair<int,int> > > groups(m_numThreads);
+        nextGroup = 0;
+        runThreads([&](int t) {
+            for(int first=nextGroup.fetch_add(chunk); first<numGroups; first=nextGroup.fetch_add(chunk)) {
+                for(int g=first; g<std::min(first+chunk, numGroups); g++) {
+                    int start = m_groups[g].first;
+                    int size  = m_groups[g].second;
+                    uint64_t* groupKeys = &keys[keyStarts[g]];
+                    std::sort(groupKeys, groupKeys+size);
+                    for(int k=0, subStart=0; k<size; k++) {
+                        if(k>0 && (groupKeys[k]>>32)!=(groupKeys[k-1]>>32)) {
+                            if(k-subStart>1 && (groupKeys[k-1]>>32)!=0) { groups[t].push_back(std::make_pair(start+subStart, k-subStart)); }
+                            subStart = k;
+                        }
+                        int id         = (uint32_t)groupKeys[k];
+                        order[start+k] = id;
+                        m_ranks[id]    = start+subStart;
+                        if(k==size-1 && size-subStart>1 && (groupKeys[k]>>32)!=0) {
+                            groups[t].push_back(std::make_pair(start+subStart, size-subStart));
+                        }
+                    }
+                }
+            }
+        });
+        m_groups.clear();
+        for(int t=0; t<m_numThreads; t++) {
+            m_groups.insert(m_groups.end(), groups[t].begin(), groups[t].end());
+        }
+        idStep *= 2;
+    }
+}
+//======================================================
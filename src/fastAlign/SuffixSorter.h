@@ -0,0 +1,58 @@
+#ifndef _SUFFIX_SORTER_H_
+#define _SUFFIX_SORTER_H_
+
+#include <climits>
+#include <cstddef>
+#include <vector>
+#include <utility>
+#include <stdint.h>
+
+//======================================================
+/** Sorts the suffixes starting at every step-th offset of a set of strings in the order of
+    SuffixArray::compareBases (bases compared as chars, a suffix that is a prefix of another
+    one coming first), with equal suffixes kept in string then offset order.
+    The suffixes are first bucketed and sorted on a prefix of a multiple of the step in length,
+    packed into 64-bit words at as few bits per base as the alphabet of the strings allows.
+    Suffixes that share that prefix are then told apart by prefix doubling: as the prefix length
+    h is a multiple of the step, the suffix h bases on is itself a sampled suffix, and its rank
+    sorts the prefixes on 2h bases. Each round only visits the suffixes that are still tied, so
+    repeats cost a round per doubling of their length rather than comparisons that walk them.
+    Buckets and tied groups are split over the given number of threads. */
+class SuffixSorter {
+public:
+    SuffixSorter(int step, int numThreads): m_step(step), m_numThreads(numThreads>1? numThreads: 1),
+                 m_strings(NULL), m_lengths(NULL), m_firstIds(), m_ranks(), m_groups(),
+                 m_bits(0), m_basesPerWord(0), m_prefixLen(0), m_numWords(0) {}
+
+    /** Sorts the sampled suffixes of the given strings, of the given lengths. Each suffix is
+        identified by its index in string then offset order, and order returns these in sorted order */
+    void sort(const std::vector<const char*>& strings, const std::vector<int>& lengths, std::vector<int>& order);
+
+private:
+    void setAlphabet();
+    void sortPrefixes(std::vector<int>& order);
+    void refineGroups(std::vector<int>& order);
+
+    int getStringIdx(int id) const;
+    /** Packs numBases bases of the given string from the given offset into the upper bits of a word, past its end as 0 */
+    uint64_t packBases(int strIdx, int offset, int numBases) const;
+    /** Runs func(threadIdx) on each thread and waits for all to finish */
+    template<class FuncType>
+    void runThreads(FuncType func) const;
+
+    int                             m_step;           /// The offset between the sampled suffixes of a string
+    int                             m_numThreads;     /// Number of threads to sort with
+    const std::vector<const char*>* m_strings;        /// The strings being sorted
+    const std::vector<int>*         m_lengths;        /// The length of each string
+    std::vector<int>                m_firstIds;       /// The id of the first suffix of each string, followed by the total number of suffixes
+    std::vector<int>                m_ranks;          /// For each suffix id, the sorted position of the first suffix sharing its prefix so far
+    std::vector<std::pair<int,int> > m_groups;        /// The start and size of the groups of suffixes still tied
+    int                             m_baseRanks[UCHAR_MAX+1]; /// The rank of each base in char order, starting from 1 as 0 marks the end of a string
+    int                             m_bits;           /// Number of bits each base is packed into
+    int                             m_basesPerWord;   /// Number of bases packed into a word
+    int                             m_prefixLen;      /// Length of the prefix sorted on by the radix buckets, a multiple of the step
+    int                             m_numWords;       /// Number of words that hold the prefix
+};
+//======================================================
+
+#endif //_SUFFIX_SORTER_H_